@@ -0,0 +1,851 @@
+#include "StandInBackend.h"
+#include <UnigineEngine.h>
+#include <UnigineLog.h>
+#include <UnigineWidgets.h>
+#include <UnigineTextures.h>
+#include <UnigineImage.h>
+#include <UnigineAsyncQueue.h>
+#include <UnigineJson.h>
+#include <UnigineXml.h>
+#include <UnigineFileSystem.h>
+#include <UnigineTimer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <malloc.h>
+
+using namespace Unigine;
+
+namespace
+{
+	standIn::AllocationCounters counters;
+	uint32_t objectCount = 0;
+	void (*allocationHook)(size_t bytes) = nullptr;
+
+	void* allocate(size_t size, size_t alignment)
+	{
+		void* ptr = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) : std::malloc(size ? size : 1);
+		if (!ptr)
+			throw std::bad_alloc();
+
+		const size_t bytes = malloc_usable_size(ptr);
+		counters.allocationCount++;
+		counters.allocatedBytes += bytes;
+		counters.liveBytes += bytes;
+		counters.peakBytes = std::max(counters.peakBytes, counters.liveBytes);
+
+		if (allocationHook)
+			allocationHook(bytes);
+
+		return ptr;
+	}
+
+	void deallocate(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		counters.liveBytes -= malloc_usable_size(ptr);
+		std::free(ptr);
+	}
+
+	// Internal object behind every stand-in interface, it owns the interface the same way engine objects do
+	class Object : public UnigineBaseObject
+	{
+	public:
+		Object() { objectCount++; }
+		~Object() override { objectCount--; }
+
+		template<typename Type>
+		Ptr<Type> attach()
+		{
+			struct Interface : Type
+			{
+				Interface(UnigineBaseObject* object) { this->setInternalObject(object); }
+			};
+
+			api_interface = new Interface(this);
+			return Ptr<Type>(this, true);
+		}
+
+	protected:
+		APIInterface* create_interface() override { return nullptr; }
+		void delete_safe() override { delete this; }
+	};
+
+	struct GuiObject : Object
+	{
+		Math::ivec2 size;
+		Math::ivec2 mouse;
+		int32_t mouseButtons = 0;
+		std::vector<WidgetPtr> children;
+	};
+
+	GuiObject* defaultGui = nullptr;
+
+	struct WidgetObject : Object
+	{
+		Widget::TYPE type = Widget::WIDGET_VBOX;
+		GuiObject* gui = defaultGui;
+		WidgetObject* parent = nullptr;
+		std::vector<WidgetPtr> children;
+
+		int32_t width = 0;
+		int32_t height = 0;
+		int32_t flags = 0;
+		int32_t fontSize = 16;
+		int32_t fontHSpacing = 0;
+		int32_t fontVSpacing = 0;
+		int32_t fontWrap = 0;
+		String text;
+
+		Math::ivec2 position;
+		int32_t layerCount = 1;
+		std::vector<Math::vec4> layerTexCoords = { Math::vec4(0.f, 0.f, 1.f, 1.f) };
+		int32_t scrollValue = 0;
+		WidgetScrollPtr vScroll;
+
+		EventInvoker<const WidgetPtr&, int> eventClicked;
+
+		std::vector<std::vector<Math::vec2>> lines;
+
+		~WidgetObject() override
+		{
+			for (const WidgetPtr& child : children)
+				get(child.get())->parent = nullptr;
+		}
+
+		static WidgetObject* get(const Widget* widget) { return static_cast<WidgetObject*>(widget->getInternalObject()); }
+	};
+
+	struct TextureObject : Object
+	{
+		Math::ivec2 size;
+	};
+
+	struct ImageObject : Object
+	{
+		Math::ivec2 size;
+		int32_t format = Image::FORMAT_RGBA8;
+		std::vector<Image::Pixel> pixels;
+	};
+
+	template<typename Type>
+	Ptr<Type> createWidget(Widget::TYPE type)
+	{
+		WidgetObject* object = new WidgetObject();
+		object->type = type;
+
+		return object->attach<Type>();
+	}
+
+	GuiObject* guiObject(const Gui* gui) { return static_cast<GuiObject*>(gui->getInternalObject()); }
+	TextureObject* textureObject(const Texture* texture) { return static_cast<TextureObject*>(texture->getInternalObject()); }
+	ImageObject* imageObject(const Image* image) { return static_cast<ImageObject*>(image->getInternalObject()); }
+
+	// fixed metrics: glyphs are half as wide as the font size and lines are one font size tall
+	Math::ivec2 measureText(const WidgetObject* widget, const char* text)
+	{
+		int32_t lineCount = 1;
+		int32_t longestLine = 0;
+		int32_t line = 0;
+		for (const char* c = text; c && *c; c++)
+		{
+			if (*c == '\n')
+			{
+				lineCount++;
+				line = 0;
+				continue;
+			}
+
+			longestLine = std::max(longestLine, ++line);
+		}
+
+		const int32_t glyphWidth = widget->fontSize / 2 + widget->fontHSpacing;
+		const int32_t lineHeight = widget->fontSize + widget->fontVSpacing;
+
+		return Math::ivec2(longestLine * glyphWidth, lineCount * lineHeight);
+	}
+
+	std::vector<Ptr<Image>> pendingImages;
+}
+
+void* operator new(size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void operator delete(void* ptr) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { deallocate(ptr); }
+
+namespace standIn
+{
+	GuiPtr createGui(int32_t width, int32_t height)
+	{
+		GuiObject* gui = new GuiObject();
+		gui->size = Math::ivec2(width, height);
+		defaultGui = gui;
+
+		return gui->attach<Gui>();
+	}
+
+	void setGuiSize(const GuiPtr& gui, int32_t width, int32_t height)
+	{
+		guiObject(gui.get())->size = Math::ivec2(width, height);
+	}
+
+	void setMouse(const GuiPtr& gui, int32_t x, int32_t y, int32_t buttons)
+	{
+		GuiObject* object = guiObject(gui.get());
+		object->mouse = Math::ivec2(x, y);
+		object->mouseButtons = buttons;
+	}
+
+	uint32_t getObjectCount()
+	{
+		return objectCount;
+	}
+
+	const AllocationCounters& getAllocationCounters()
+	{
+		return counters;
+	}
+
+	void resetPeakBytes()
+	{
+		counters.peakBytes = counters.liveBytes;
+	}
+
+	void setAllocationHook(void (*hook)(size_t bytes))
+	{
+		allocationHook = hook;
+	}
+}
+
+// Core
+
+UnigineBaseObject::~UnigineBaseObject()
+{
+	if (api_interface)
+		api_interface->object_destructor();
+}
+
+APIInterface* UnigineBaseObject::getInterface()
+{
+	return api_interface;
+}
+
+void UnigineBaseObject::delete_safe()
+{
+	delete this;
+}
+
+void* Memory::allocate(size_t size) { return ::operator new(size); }
+void Memory::deallocate(void* ptr) { ::operator delete(ptr); }
+bool Memory::tryReallocate(void* ptr, size_t size) { return false; }
+void Memory::shutdown_pool(Pool& pool) {}
+// without engine frames there is nothing to attribute allocations to, see getAllocationCounters instead
+bool Memory::isStatisticsEnabled() { return false; }
+int Memory::getFrameAllocations() { return 0; }
+void Memory::deallocate_pool(Pool& pool, size_t freeLimit, void* ptr) { ::operator delete(ptr); }
+
+void Log::error(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+}
+
+void Log::warning(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+}
+
+long long Time::get()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Engine* Engine::get()
+{
+	// there is no engine loop, callers pass the frame time explicitly
+	return nullptr;
+}
+
+StringStack<> String::substr(int pos, int size) const
+{
+	StringStack<> result;
+	pos = std::clamp(pos, 0, length);
+	if (size < 0 || pos + size > length)
+		size = length - pos;
+
+	result.append(data + pos, size);
+	return result;
+}
+
+StringArray<> String::split(const char* str, const char* delimiters)
+{
+	const int size = static_cast<int>(strlen(str));
+
+	StringArray<> result(size);
+	memcpy(result.data, str, size);
+
+	int begin = 0;
+	for (int i = 0; i <= size; i++)
+	{
+		if (i < size && !strchr(delimiters, str[i]))
+			continue;
+
+		result.data[i] = '\0';
+		if (i > begin)
+			result.append(begin);
+		begin = i + 1;
+	}
+
+	return result;
+}
+
+// Gui
+
+Math::ivec2 Gui::getSize() const { return guiObject(this)->size; }
+int Gui::getHeight() const { return guiObject(this)->size.y; }
+int Gui::getMouseX() const { return guiObject(this)->mouse.x; }
+int Gui::getMouseY() const { return guiObject(this)->mouse.y; }
+int Gui::getMouseButtons() const { return guiObject(this)->mouseButtons; }
+void Gui::clearDictionaries() {}
+bool Gui::addDictionary(const char* name, const char* language) { return true; }
+const char* Gui::translate(const char* str) { return str; }
+
+void Gui::addChild(const WidgetPtr& widget, int flags)
+{
+	guiObject(this)->children.push_back(widget);
+	WidgetObject::get(widget.get())->gui = guiObject(this);
+}
+
+void Gui::removeChild(const WidgetPtr& widget)
+{
+	std::vector<WidgetPtr>& children = guiObject(this)->children;
+	children.erase(std::remove(children.begin(), children.end(), widget), children.end());
+}
+
+int Gui::isChild(const WidgetPtr& widget) const
+{
+	const std::vector<WidgetPtr>& children = guiObject(this)->children;
+	return std::find(children.begin(), children.end(), widget) != children.end();
+}
+
+// Widgets
+
+Widget::TYPE Widget::getType() const { return WidgetObject::get(this)->type; }
+void Widget::setFlags(int flags) { WidgetObject::get(this)->flags = flags; }
+void Widget::setGui(const GuiPtr& gui) { WidgetObject::get(this)->gui = gui ? guiObject(gui.get()) : nullptr; }
+
+GuiPtr Widget::getGui() const
+{
+	const WidgetObject* widget = WidgetObject::get(this);
+	while (widget->parent)
+		widget = widget->parent;
+
+	return widget->gui ? GuiPtr(static_cast<Gui*>(widget->gui->getInterface())) : GuiPtr();
+}
+
+WidgetPtr Widget::getParent() const
+{
+	WidgetObject* parent = WidgetObject::get(this)->parent;
+	return parent ? WidgetPtr(static_cast<Widget*>(parent->getInterface())) : WidgetPtr();
+}
+
+void Widget::setPosition(int x, int y) { WidgetObject::get(this)->position = Math::ivec2(x, y); }
+void Widget::setWidth(int width) { WidgetObject::get(this)->width = width; }
+int Widget::getWidth() const { return WidgetObject::get(this)->width; }
+void Widget::setHeight(int height) { WidgetObject::get(this)->height = height; }
+int Widget::getHeight() const { return WidgetObject::get(this)->height; }
+Math::ivec2 Widget::getTextRenderSize(const char* text) const { return measureText(WidgetObject::get(this), text); }
+void Widget::setFont(const char* name) {}
+void Widget::setFontSize(int size) { WidgetObject::get(this)->fontSize = size; }
+int Widget::getFontSize() const { return WidgetObject::get(this)->fontSize; }
+void Widget::setFontHSpacing(int hspacing) { WidgetObject::get(this)->fontHSpacing = hspacing; }
+void Widget::setFontVSpacing(int vspacing) { WidgetObject::get(this)->fontVSpacing = vspacing; }
+void Widget::setFontWrap(int wrap) { WidgetObject::get(this)->fontWrap = wrap; }
+Event<const WidgetPtr&, int>& Widget::getEventClicked() { return WidgetObject::get(this)->eventClicked; }
+
+void Widget::addChild(const WidgetPtr& w, int flags)
+{
+	WidgetObject* child = WidgetObject::get(w.get());
+	if (child->parent)
+		Ptr<Widget>(static_cast<Widget*>(child->parent->getInterface()))->removeChild(w);
+
+	child->parent = WidgetObject::get(this);
+	child->parent->children.push_back(w);
+}
+
+void Widget::removeChild(const WidgetPtr& w)
+{
+	WidgetObject* widget = WidgetObject::get(this);
+	auto it = std::find(widget->children.begin(), widget->children.end(), w);
+	if (it == widget->children.end())
+		return;
+
+	// the child may only be kept alive by this reference
+	WidgetPtr child = *it;
+	widget->children.erase(it);
+	WidgetObject::get(child.get())->parent = nullptr;
+}
+
+Ptr<WidgetVBox> WidgetVBox::create(int x, int y) { return createWidget<WidgetVBox>(Widget::WIDGET_VBOX); }
+void WidgetVBox::setPadding(int l, int r, int t, int b) {}
+void WidgetVBox::setStencil(int stencil) {}
+void WidgetVBox::setBackground(int background) {}
+void WidgetVBox::setBackgroundColor(const Math::vec4& color) {}
+void WidgetVBox::setBackgroundRender(const Ptr<Texture>& texture, int flipped) {}
+void WidgetVBox::setBackground9Sliced(bool sliced) {}
+void WidgetVBox::setBackground9SliceOffsets(float l, float r, float t, float b) {}
+void WidgetVBox::setBackground9SliceScale(float scale) {}
+void WidgetVBox::setBackgroundCustomFilterEnabled(bool enabled) {}
+void WidgetVBox::setBackgroundCustomFilter(int filter) {}
+
+Ptr<WidgetHBox> WidgetHBox::create(int x, int y) { return createWidget<WidgetHBox>(Widget::WIDGET_HBOX); }
+
+Ptr<WidgetLabel> WidgetLabel::create(const char* str)
+{
+	Ptr<WidgetLabel> label = createWidget<WidgetLabel>(Widget::WIDGET_LABEL);
+	label->setText(str ? str : "");
+	return label;
+}
+
+void WidgetLabel::setTextAlign(int align) {}
+void WidgetLabel::setText(const char* text) { WidgetObject::get(this)->text = text; }
+
+Ptr<WidgetEditLine> WidgetEditLine::create(const char* str)
+{
+	Ptr<WidgetEditLine> editLine = createWidget<WidgetEditLine>(Widget::WIDGET_EDIT_LINE);
+	editLine->setText(str ? str : "");
+	return editLine;
+}
+
+void WidgetEditLine::setText(const char* text) { WidgetObject::get(this)->text = text; }
+const char* WidgetEditLine::getText() const { return WidgetObject::get(this)->text.get(); }
+void WidgetEditLine::setBackgroundColor(const Math::vec4& color) {}
+void WidgetEditLine::setBorderColor(const Math::vec4& color) {}
+void WidgetEditLine::setStyleTextureBackground(const char* path) {}
+
+Ptr<WidgetScrollBox> WidgetScrollBox::create(int x, int y)
+{
+	Ptr<WidgetScrollBox> scrollBox = createWidget<WidgetScrollBox>(Widget::WIDGET_SCROLL_BOX);
+	WidgetObject::get(scrollBox.get())->vScroll = createWidget<WidgetScroll>(Widget::WIDGET_SCROLL);
+	return scrollBox;
+}
+
+void WidgetScrollBox::setBorder(int border) {}
+void WidgetScrollBox::setVScrollEnabled(bool enabled) {}
+void WidgetScrollBox::setHScrollEnabled(bool enabled) {}
+void WidgetScrollBox::setVScrollValue(int value) { WidgetObject::get(this)->scrollValue = value; }
+int WidgetScrollBox::getVScrollValue() const { return WidgetObject::get(this)->scrollValue; }
+Ptr<WidgetScroll> WidgetScrollBox::getVScroll() const { return WidgetObject::get(this)->vScroll; }
+void WidgetScroll::setSliderButton(bool button) {}
+
+Ptr<WidgetSprite> WidgetSprite::create(const char* name) { return createWidget<WidgetSprite>(Widget::WIDGET_SPRITE); }
+
+int WidgetSprite::addLayer()
+{
+	WidgetObject* object = WidgetObject::get(this);
+	object->layerTexCoords.push_back(Math::vec4(0.f, 0.f, 1.f, 1.f));
+	return object->layerCount++;
+}
+
+int WidgetSprite::getNumLayers() const { return WidgetObject::get(this)->layerCount; }
+void WidgetSprite::setRender(const Ptr<Texture>& texture, int flipped) {}
+void WidgetSprite::setLayerEnabled(int layer, bool enabled) {}
+void WidgetSprite::setLayerTexCoord(int layer, const Math::vec4& texcoord) { WidgetObject::get(this)->layerTexCoords[layer] = texcoord; }
+Math::vec4 WidgetSprite::getLayerTexCoord(int layer) const { return WidgetObject::get(this)->layerTexCoords[layer]; }
+void WidgetSprite::setLayerRender(int layer, const Ptr<Texture>& texture, int flipped) {}
+
+Ptr<WidgetCanvas> WidgetCanvas::create() { return createWidget<WidgetCanvas>(Widget::WIDGET_CANVAS); }
+
+int WidgetCanvas::addLine(int order)
+{
+	std::vector<std::vector<Math::vec2>>& lines = WidgetObject::get(this)->lines;
+	lines.emplace_back();
+	return static_cast<int>(lines.size()) - 1;
+}
+
+void WidgetCanvas::setLineColor(int line, const Math::vec4& color) {}
+void WidgetCanvas::clearLinePoints(int line) { WidgetObject::get(this)->lines[line].clear(); }
+int WidgetCanvas::getNumLinePoints(int line) const { return static_cast<int>(WidgetObject::get(this)->lines[line].size()); }
+void WidgetCanvas::setLinePoint(int line, int num, const Math::vec2& point) { WidgetObject::get(this)->lines[line][num] = point; }
+
+int WidgetCanvas::addLinePoint(int line, const Math::vec2& point)
+{
+	std::vector<Math::vec2>& points = WidgetObject::get(this)->lines[line];
+	points.push_back(point);
+	return static_cast<int>(points.size()) - 1;
+}
+
+// Resources, there are no files to read so textures load as a single white pixel
+
+Ptr<Texture> Texture::create() { return (new TextureObject())->attach<Texture>(); }
+
+bool Texture::load(const char* name, int flags)
+{
+	textureObject(this)->size = Math::ivec2(1, 1);
+	return true;
+}
+
+bool Texture::create(const Ptr<Image>& image, int flags, int skipMipmaps, int format)
+{
+	textureObject(this)->size = Math::ivec2(image->getWidth(), image->getHeight());
+	return true;
+}
+
+size_t Texture::getVideoMemoryUsage() const
+{
+	const Math::ivec2& size = textureObject(this)->size;
+	return static_cast<size_t>(size.x) * size.y * 4;
+}
+
+Ptr<Image> Image::create() { return (new ImageObject())->attach<Image>(); }
+bool Image::info(const char* file) { return false; }
+bool Image::load(const char* file) { return false; }
+int Image::getWidth() const { return imageObject(this)->size.x; }
+int Image::getHeight() const { return imageObject(this)->size.y; }
+bool Image::isCompressedFormat() const { return false; }
+bool Image::decompress() { return true; }
+
+bool Image::create2D(int width, int height, int format, int numMipmaps, bool clear, bool allocate)
+{
+	ImageObject* image = imageObject(this);
+	image->size = Math::ivec2(width, height);
+	image->format = format;
+	image->pixels.assign(static_cast<size_t>(width) * height, Pixel(0, 0, 0, 0));
+	return true;
+}
+
+bool Image::convertToFormat(int newFormat)
+{
+	imageObject(this)->format = newFormat;
+	return true;
+}
+
+void Image::set2D(int x, int y, const Pixel& p)
+{
+	ImageObject* image = imageObject(this);
+	image->pixels[static_cast<size_t>(y) * image->size.x + x] = p;
+}
+
+Image::Pixel Image::get2D(int x, int y) const
+{
+	const ImageObject* image = imageObject(this);
+	return image->pixels[static_cast<size_t>(y) * image->size.x + x];
+}
+
+bool Image::copy(const Ptr<Image>& srcImage, int xDst, int yDst, int xSrc, int ySrc, int width, int height, bool safe)
+{
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+			set2D(xDst + x, yDst + y, srcImage->get2D(xSrc + x, ySrc + y));
+	}
+
+	return true;
+}
+
+int AsyncQueue::loadImage(const char* name, int group, float weight)
+{
+	Ptr<Image> image = Image::create();
+	image->create2D(1, 1, Image::FORMAT_RGBA8);
+	image->set2D(0, 0, Image::Pixel(255, 255, 255, 255));
+
+	pendingImages.push_back(image);
+	return static_cast<int>(pendingImages.size()) - 1;
+}
+
+int AsyncQueue::checkImage(int id) { return id >= 0 && id < static_cast<int>(pendingImages.size()) && pendingImages[id]; }
+
+Ptr<Image> AsyncQueue::takeImage(int id)
+{
+	Ptr<Image> image = pendingImages[id];
+	pendingImages[id] = nullptr;
+	return image;
+}
+
+int AsyncQueue::removeImage(int id)
+{
+	pendingImages[id] = nullptr;
+	return 1;
+}
+
+// Json is only used for reports, which the benchmarks don't touch
+
+Ptr<Json> Json::create() { return nullptr; }
+Ptr<Json> Json::addChild() { return nullptr; }
+Ptr<Json> Json::addChild(const char* name) { return nullptr; }
+Ptr<Json> Json::addChild(const char* name, int value) { return nullptr; }
+Ptr<Json> Json::addChild(const char* name, const char* value) { return nullptr; }
+Ptr<Json> Json::addChild(const char* name, double value) { return nullptr; }
+void Json::setArray() {}
+void Json::setObject() {}
+String Json::getFormattedSubTree(const char* name) { return String(); }
+int Json::save(const char* path) const { return 0; }
+
+// data paths are relative to the working directory
+String FileSystem::getAbsolutePath(const char* path) { return String(path); }
+
+// Xml covers what UI descriptions and dictionaries need: elements, attributes, text, comments and entities
+
+namespace
+{
+	struct XmlObject : Object
+	{
+		String name;
+		std::vector<std::pair<String, String>> args;
+		String data;
+		std::vector<XmlPtr> children;
+
+		static XmlObject* get(const Xml* xml) { return static_cast<XmlObject*>(xml->getInternalObject()); }
+	};
+
+	class XmlParser
+	{
+	public:
+		XmlParser(const char* source) : cursor(source) {}
+
+		bool parseDocument(XmlObject* root)
+		{
+			skipMisc();
+			if (*cursor != '<' || !parseElement(root))
+				return false;
+
+			skipMisc();
+			return *cursor == '\0';
+		}
+
+	private:
+		const char* cursor;
+
+		static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+		static bool isNameChar(char c) { return c && !isSpace(c) && !strchr("<>/=\"'?!", c); }
+
+		void skipSpaces()
+		{
+			while (isSpace(*cursor))
+				cursor++;
+		}
+
+		bool skipPast(const char* end)
+		{
+			const char* found = strstr(cursor, end);
+			if (!found)
+				return false;
+
+			cursor = found + strlen(end);
+			return true;
+		}
+
+		// declarations, processing instructions and comments between elements
+		void skipMisc()
+		{
+			for (;;)
+			{
+				skipSpaces();
+				if (!strncmp(cursor, "<?", 2))
+				{
+					if (!skipPast("?>"))
+						return;
+				}
+				else if (!strncmp(cursor, "<!--", 4))
+				{
+					if (!skipPast("-->"))
+						return;
+				}
+				else
+					return;
+			}
+		}
+
+		bool parseName(String& name)
+		{
+			const char* begin = cursor;
+			while (isNameChar(*cursor))
+				cursor++;
+
+			name = String(begin, static_cast<int>(cursor - begin));
+			return cursor != begin;
+		}
+
+		bool parseText(char terminator, String& text)
+		{
+			while (*cursor && *cursor != terminator)
+			{
+				if (*cursor != '&')
+				{
+					const char* begin = cursor;
+					while (*cursor && *cursor != terminator && *cursor != '&')
+						cursor++;
+
+					text.append(begin, static_cast<int>(cursor - begin));
+					continue;
+				}
+
+				static const char* const entities[][2] = { { "&amp;", "&" }, { "&lt;", "<" }, { "&gt;", ">" }, { "&quot;", "\"" }, { "&apos;", "'" } };
+				bool isKnown = false;
+				for (const auto& entity : entities)
+				{
+					if (!strncmp(cursor, entity[0], strlen(entity[0])))
+					{
+						text.append(entity[1]);
+						cursor += strlen(entity[0]);
+						isKnown = true;
+						break;
+					}
+				}
+
+				if (!isKnown)
+					return false;
+			}
+
+			return *cursor == terminator;
+		}
+
+		bool parseElement(XmlObject* element)
+		{
+			cursor++;
+			if (!parseName(element->name))
+				return false;
+
+			for (;;)
+			{
+				skipSpaces();
+				if (!strncmp(cursor, "/>", 2))
+				{
+					cursor += 2;
+					return true;
+				}
+
+				if (*cursor == '>')
+				{
+					cursor++;
+					break;
+				}
+
+				String name, value;
+				if (!parseName(name))
+					return false;
+
+				skipSpaces();
+				if (*cursor++ != '=')
+					return false;
+
+				skipSpaces();
+				const char quote = *cursor++;
+				if ((quote != '"' && quote != '\'') || !parseText(quote, value))
+					return false;
+
+				cursor++;
+				element->args.emplace_back(std::move(name), std::move(value));
+			}
+
+			for (;;)
+			{
+				if (!parseText('<', element->data))
+					return false;
+
+				if (!strncmp(cursor, "<!--", 4))
+				{
+					if (!skipPast("-->"))
+						return false;
+				}
+				else if (!strncmp(cursor, "</", 2))
+				{
+					cursor += 2;
+					String name;
+					if (!parseName(name) || strcmp(name.get(), element->name.get()))
+						return false;
+
+					skipSpaces();
+					if (*cursor++ != '>')
+						return false;
+
+					// indentation around children isn't data
+					const char* data = element->data.get();
+					if (!element->children.empty() && strspn(data, " \t\r\n") == strlen(data))
+						element->data.clear();
+
+					return true;
+				}
+				else
+				{
+					XmlObject* child = new XmlObject();
+					element->children.push_back(child->attach<Xml>());
+					if (!parseElement(child))
+						return false;
+				}
+			}
+		}
+	};
+}
+
+Ptr<Xml> Xml::create() { return (new XmlObject())->attach<Xml>(); }
+
+bool Xml::parse(const char* src)
+{
+	XmlObject* xml = XmlObject::get(this);
+	xml->name.clear();
+	xml->args.clear();
+	xml->data.clear();
+	xml->children.clear();
+
+	return XmlParser(src).parseDocument(xml);
+}
+
+bool Xml::load(const char* name, bool skipErrors)
+{
+	FILE* file = fopen(name, "rb");
+	if (!file)
+		return false;
+
+	std::vector<char> source;
+	char buffer[4096];
+	size_t size = 0;
+	while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		source.insert(source.end(), buffer, buffer + size);
+
+	fclose(file);
+	source.push_back('\0');
+
+	return parse(source.data());
+}
+
+const char* Xml::getName() const { return XmlObject::get(this)->name.get(); }
+int Xml::getNumArgs() const { return static_cast<int>(XmlObject::get(this)->args.size()); }
+const char* Xml::getArgName(int num) const { return XmlObject::get(this)->args[num].first.get(); }
+const char* Xml::getArgValue(int num) const { return XmlObject::get(this)->args[num].second.get(); }
+
+int Xml::findChild(const char* name) const
+{
+	const std::vector<XmlPtr>& children = XmlObject::get(this)->children;
+	for (size_t i = 0; i < children.size(); i++)
+	{
+		if (!strcmp(children[i]->getName(), name))
+			return static_cast<int>(i);
+	}
+
+	return -1;
+}
+
+int Xml::getNumChildren() const { return static_cast<int>(XmlObject::get(this)->children.size()); }
+Ptr<Xml> Xml::getChild(int num) const { return XmlObject::get(this)->children[num]; }
+const char* Xml::getData() const { return XmlObject::get(this)->data.get(); }
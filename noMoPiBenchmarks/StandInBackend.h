@@ -0,0 +1,31 @@
+#pragma once
+#include <UnigineGui.h>
+#include <cstddef>
+#include <cstdint>
+
+// Headless replacement for the engine symbols noMorePixels links against. Widgets live in plain memory and text
+// is measured with fixed glyph metrics.
+namespace standIn
+{
+	// The gui every widget created without an explicit one belongs to, the last created gui becomes the default
+	Unigine::GuiPtr createGui(int32_t width, int32_t height);
+	void setGuiSize(const Unigine::GuiPtr& gui, int32_t width, int32_t height);
+	void setMouse(const Unigine::GuiPtr& gui, int32_t x, int32_t y, int32_t buttons);
+
+	// Engine side objects alive right now, widgets, textures and images included
+	uint32_t getObjectCount();
+
+	// Every heap allocation of the process goes through these counters
+	struct AllocationCounters
+	{
+		uint64_t allocationCount = 0;
+		uint64_t allocatedBytes = 0;
+		size_t liveBytes = 0;
+		size_t peakBytes = 0;
+	};
+
+	const AllocationCounters& getAllocationCounters();
+	void resetPeakBytes();
+	// Called after every counted allocation, for forwarding them to noMoPi::AllocationTracker::onAllocate
+	void setAllocationHook(void (*hook)(size_t bytes));
+}
@@ -0,0 +1,612 @@
+#include "StandInBackend.h"
+#include "noMorePixels/noMorePixels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace noMoPi;
+
+namespace
+{
+	struct Scenario
+	{
+		const char* name;
+		std::function<std::shared_ptr<WidgetBase>()> build;
+	};
+
+	struct Measurement
+	{
+		const char* operation = "";
+		int32_t iterations = 0;
+		double nsPerOp = 0.0;
+		double minNs = 0.0;
+		double allocationsPerOp = 0.0;
+		double bytesPerOp = 0.0;
+		// heap growth above the live size before the first iteration
+		size_t peakBytes = 0;
+	};
+
+	struct Result
+	{
+		const char* scenario = "";
+		size_t widgetCount = 0;
+		uint32_t engineObjectCount = 0;
+		// points where the spatial index and the linear traversal picked different widgets
+		int32_t hitTestMismatchCount = 0;
+		std::vector<Measurement> measurements;
+	};
+
+	std::shared_ptr<Label> makeLabel(const char* text, bool isTranslatable = false)
+	{
+		auto label = Label::create();
+		label->setText(text, isTranslatable)->setTextAlign(Align::Center, Align::Center);
+		return label;
+	}
+
+	// Alternating boxes nested one level per iteration, each level also holds a label
+	std::shared_ptr<WidgetBase> buildDeepNesting()
+	{
+		constexpr int32_t depth = 64;
+
+		auto root = VBox::create();
+		std::shared_ptr<WidgetContainer> current = root;
+		for (int32_t i = 0; i < depth; i++)
+		{
+			std::shared_ptr<WidgetContainer> child;
+			if (i % 2)
+				child = HBox::create();
+			else
+				child = VBox::create();
+
+			child->setPadding(0.01f, 0.01f, 0.01f, 0.01f)->setSpacing(0.01f);
+
+			current->addChild(makeLabel("Nested level"));
+			current->addChild(child);
+			current = child;
+		}
+
+		return root;
+	}
+
+	std::shared_ptr<WidgetBase> buildWideHBox()
+	{
+		constexpr int32_t width = 512;
+
+		auto root = VBox::create();
+		auto row = HBox::create();
+		row->setSpacing(0.001f);
+		for (int32_t i = 0; i < width; i++)
+			row->addChild(makeLabel("Cell"));
+
+		root->addChild(row);
+		return root;
+	}
+
+	std::shared_ptr<WidgetBase> buildLabelPanel()
+	{
+		constexpr int32_t rows = 48;
+		constexpr int32_t columns = 6;
+
+		auto root = VBox::create();
+		root->setBackgroundEnabled(true)
+			->setPadding(0.02f, 0.02f, 0.02f, 0.02f)
+			->setSpacing(0.005f);
+
+		for (int32_t i = 0; i < rows; i++)
+		{
+			auto row = HBox::create();
+			row->setSpacing(0.01f);
+			for (int32_t j = 0; j < columns; j++)
+				row->addChild(makeLabel(j ? "Value 12345" : "Property name", true));
+
+			root->addChild(row);
+		}
+
+		return root;
+	}
+
+	std::shared_ptr<WidgetBase> buildBigScrollBox()
+	{
+		constexpr int32_t items = 2000;
+
+		auto root = VBox::create();
+		auto scrollBox = ScrollBox::create();
+		scrollBox->setVisibleItemCount(20);
+		for (int32_t i = 0; i < items; i++)
+		{
+			auto row = HBox::create();
+			row->addChild(makeLabel("Item"));
+			row->addChild(makeLabel("Description of the item"));
+			scrollBox->addChild(row);
+		}
+
+		root->addChild(scrollBox);
+		return root;
+	}
+
+	// A check box picking can find, the library leaves Interactive to game widgets
+	class InteractiveCheckBox : public CheckBox, public Interactive
+	{
+	public:
+		InteractiveCheckBox(const ScaleSettings& scaleSettings) : CheckBox(scaleSettings) {}
+	};
+
+	std::shared_ptr<WidgetBase> buildCheckBoxGrid()
+	{
+		constexpr int32_t rows = 32;
+		constexpr int32_t columns = 16;
+
+		auto root = VBox::create();
+		for (int32_t i = 0; i < rows; i++)
+		{
+			auto row = HBox::create();
+			for (int32_t j = 0; j < columns; j++)
+			{
+				row->addChild(makeWidget<InteractiveCheckBox>(ScaleSettings()));
+				row->addChild(makeLabel("Option"));
+			}
+
+			root->addChild(row);
+		}
+
+		return root;
+	}
+
+	// The rows of bigScrollBox as a UI description, 5000 widgets
+	const std::string& getScreenDescription()
+	{
+		constexpr int32_t items = 1666;
+
+		static const std::string source = []() {
+			std::string xml = "<vbox>\n\t<scrollbox id=\"list\" items=\"20\">\n";
+			for (int32_t i = 0; i < items; i++)
+			{
+				xml += "\t\t<hbox>\n";
+				xml += "\t\t\t<label text=\"Item\" translatable=\"false\" align=\"center center\"/>\n";
+				xml += "\t\t\t<label text=\"Description of the item\" translatable=\"false\" align=\"center center\"/>\n";
+				xml += "\t\t</hbox>\n";
+			}
+
+			return xml + "\t</scrollbox>\n</vbox>\n";
+		}();
+
+		return source;
+	}
+
+	// construction includes the XML parse
+	std::shared_ptr<WidgetBase> buildDescribedScreen()
+	{
+		UIDescription description;
+		description.parse(getScreenDescription().c_str());
+		return description.getRoot();
+	}
+
+	// the same screen compiled, construction is a sweep over the node table
+	std::shared_ptr<WidgetBase> buildCompiledScreen()
+	{
+		static const std::vector<uint8_t> blob = []() {
+			std::vector<uint8_t> bytes;
+			Unigine::XmlPtr xml = Unigine::Xml::create();
+			xml->parse(getScreenDescription().c_str());
+			UIDescription::compile(xml, "describedScreen", bytes);
+			return bytes;
+		}();
+
+		UIDescription description;
+		description.instantiate(blob.data(), blob.size());
+		return description.getRoot();
+	}
+
+	template<typename Operation>
+	Measurement measure(const char* name, int32_t iterations, Operation&& operation)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// the first run fills caches and pools that steady state already has
+		operation();
+
+		const standIn::AllocationCounters& counters = standIn::getAllocationCounters();
+		const size_t baseBytes = counters.liveBytes;
+		standIn::resetPeakBytes();
+
+		const uint64_t allocationCount = counters.allocationCount;
+		const uint64_t allocatedBytes = counters.allocatedBytes;
+
+		Measurement measurement;
+		measurement.operation = name;
+		measurement.iterations = iterations;
+		measurement.minNs = std::numeric_limits<double>::max();
+
+		double totalNs = 0.0;
+		for (int32_t i = 0; i < iterations; i++)
+		{
+			const Clock::time_point begin = Clock::now();
+			operation();
+			const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+
+			totalNs += ns;
+			measurement.minNs = std::min(measurement.minNs, ns);
+		}
+
+		measurement.nsPerOp = totalNs / iterations;
+		measurement.allocationsPerOp = static_cast<double>(counters.allocationCount - allocationCount) / iterations;
+		measurement.bytesPerOp = static_cast<double>(counters.allocatedBytes - allocatedBytes) / iterations;
+		measurement.peakBytes = counters.peakBytes > baseBytes ? counters.peakBytes - baseBytes : 0;
+
+		return measurement;
+	}
+
+	// UI::benchmarkHitTest times both pick paths itself, its microsecond timer needs big batches
+	void measureHitTest(UI& ui, int32_t batchCount, Result& result)
+	{
+		constexpr int32_t queryCount = 4096;
+
+		Measurement indexed;
+		indexed.operation = "pickIndexed";
+		Measurement linear;
+		linear.operation = "pickLinear";
+
+		for (Measurement* measurement : { &indexed, &linear })
+		{
+			measurement->iterations = batchCount * queryCount;
+			measurement->minNs = std::numeric_limits<double>::max();
+		}
+
+		for (int32_t i = 0; i < batchCount; i++)
+		{
+			const UI::HitTestBenchmark hitTest = ui.benchmarkHitTest(queryCount);
+			const double indexedNs = hitTest.indexedMilliseconds * 1e6 / queryCount;
+			const double linearNs = hitTest.linearMilliseconds * 1e6 / queryCount;
+
+			indexed.nsPerOp += indexedNs / batchCount;
+			indexed.minNs = std::min(indexed.minNs, indexedNs);
+			linear.nsPerOp += linearNs / batchCount;
+			linear.minNs = std::min(linear.minNs, linearNs);
+
+			result.hitTestMismatchCount = std::max(result.hitTestMismatchCount, hitTest.mismatchCount);
+		}
+
+		result.measurements.push_back(indexed);
+		result.measurements.push_back(linear);
+	}
+
+	Result run(const Scenario& scenario, int32_t iterations)
+	{
+		Result result;
+		result.scenario = scenario.name;
+
+		Unigine::GuiPtr gui = standIn::createGui(1920, 1080);
+
+		// construction is slower per op than the passes over a built tree, fewer runs keep the suite short
+		const int32_t constructionIterations = std::max(1, iterations / 10);
+		result.measurements.push_back(measure("construction", constructionIterations, [&]() { scenario.build(); }));
+
+		UI ui(gui);
+		const std::shared_ptr<WidgetBase> root = scenario.build();
+		ui.setRootWidget(root);
+		ui.updateLayout();
+
+		result.widgetCount = ui.getFootprint().nodes.size();
+		result.engineObjectCount = standIn::getObjectCount();
+
+		// every pass alternates between two resolutions so no size is ever unchanged
+		bool isLarge = false;
+		result.measurements.push_back(measure("updateLayout", iterations, [&]() {
+			isLarge = !isLarge;
+			standIn::setGuiSize(gui, isLarge ? 1920 : 1280, isLarge ? 1080 : 720);
+			ui.updateLayout();
+		}));
+
+		// the same passes planned in 1 ms slices and committed at once, the overhead of resumable layout
+		LayoutJob job;
+		result.measurements.push_back(measure("slicedLayout", iterations, [&]() {
+			isLarge = !isLarge;
+			const Unigine::Math::ivec2 size = isLarge ? Unigine::Math::ivec2(1920, 1080) : Unigine::Math::ivec2(1280, 720);
+			standIn::setGuiSize(gui, size.x, size.y);
+
+			job.start(root, size.x, size.y);
+			while (!job.step(1000))
+				continue;
+
+			job.commit();
+		}));
+
+		result.measurements.push_back(measure("translate", iterations, [&]() { ui.translate(); }));
+		result.measurements.push_back(measure("tick", iterations, [&]() { ui.tick(1.f / 60.f); }));
+
+		measureHitTest(ui, std::max(1, iterations / 10), result);
+
+		return result;
+	}
+
+	// Ticks a laid out tree with AllocationTracker in test mode, false when a steady-state tick allocated
+	bool checkTickAllocations(const Scenario& scenario, int32_t tickCount)
+	{
+		Unigine::GuiPtr gui = standIn::createGui(1920, 1080);
+		UI ui(gui);
+		ui.setRootWidget(scenario.build());
+		ui.updateLayout();
+
+		AllocationTracker& tracker = AllocationTracker::get();
+		tracker.resetCounters();
+		tracker.setTickAllocationCheck(true);
+
+		for (int32_t i = 0; i < tickCount; i++)
+			ui.tick(1.f / 60.f);
+
+		const AllocationTracker::Counters& counters = tracker.getCounters(AllocationTracker::Operation::Tick);
+		fprintf(stderr, "%s: %u of %llu ticks allocated, %llu allocations, %llu bytes\n", scenario.name, tracker.getFailedTickCount(),
+			static_cast<unsigned long long>(counters.callCount), static_cast<unsigned long long>(counters.allocationCount), static_cast<unsigned long long>(counters.bytes));
+
+		const bool isPassed = tracker.getFailedTickCount() == 0;
+		tracker.setTickAllocationCheck(false);
+		return isPassed;
+	}
+
+	std::shared_ptr<WidgetBase> buildTexturedScreen()
+	{
+		auto root = VBox::create();
+		root->setBackgroundTexture("3dMenuBackground.png");
+
+		auto box = VBox::create();
+		box->setBackgroundTexture("border.png");
+		root->addChild(box);
+		root->addChild(CheckBox::create());
+
+		return root;
+	}
+
+	// Preloaded textures of a built screen have to load by the next update and be found when it is built again,
+	// and a preload nothing acquires has to expire.
+	bool checkTexturePreload()
+	{
+		Unigine::GuiPtr gui = standIn::createGui(1920, 1080);
+		TextureCache& cache = TextureCache::get();
+
+		// containers start on the white texture, one kept alive holds it in the cache so only the screen's own count
+		const std::shared_ptr<VBox> white = VBox::create();
+
+		const std::vector<ResourceId> textures = TextureCache::collectTextures(buildTexturedScreen());
+		const TextureCache::Statistics before = cache.getStatistics();
+
+		cache.preload(textures);
+		const uint32_t queuedCount = cache.getStatistics().pendingCount - before.pendingCount;
+
+		cache.update();
+		const bool isLoaded = !cache.isLoading();
+
+		const uint32_t misses = cache.getStatistics().misses;
+		const std::shared_ptr<WidgetBase> root = buildTexturedScreen();
+		const uint32_t rebuildMisses = cache.getStatistics().misses - misses;
+
+		const uint32_t textureCount = cache.getStatistics().textureCount;
+		cache.setMaxPreloadTime(0.0);
+		cache.preload(std::vector<Unigine::String>{ "unused.png" });
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		cache.update();
+		cache.setMaxPreloadTime(60.0);
+		const bool isExpired = cache.getStatistics().textureCount == textureCount;
+
+		fprintf(stderr, "texture preload: %zu textures, %u queued, %s after update, %u misses when rebuilt, unused preload %s\n", textures.size(), queuedCount,
+			isLoaded ? "all loaded" : "still loading", rebuildMisses, isExpired ? "expired" : "kept");
+
+		return !textures.empty() && queuedCount == textures.size() && isLoaded && !rebuildMisses && isExpired;
+	}
+
+	// Every pixel differs from its neighbours, so a region copied or extruded from the wrong place shows up
+	Unigine::ImagePtr createPatternImage(int32_t width, int32_t height, int32_t seed)
+	{
+		Unigine::ImagePtr image = Unigine::Image::create();
+		image->create2D(width, height, Unigine::Image::FORMAT_RGBA8);
+
+		for (int32_t y = 0; y < height; y++)
+		{
+			for (int32_t x = 0; x < width; x++)
+				image->set2D(x, y, Unigine::Image::Pixel((x * 7 + seed * 50) & 255, (y * 13) & 255, (seed * 40) & 255, 255));
+		}
+
+		return image;
+	}
+
+	// Checks packing at a few paddings, then an atlas of generated CheckBox textures against what CheckBox samples
+	bool checkAtlas()
+	{
+		const std::vector<Unigine::Math::ivec2> sizes = { { 16, 16 }, { 64, 8 }, { 1, 1 }, { 37, 21 }, { 128, 128 }, { 5, 90 }, { 200, 3 }, { 33, 33 } };
+		bool isPacked = true;
+
+		for (int32_t padding : { 0, 1, 3 })
+		{
+			std::vector<Unigine::Math::ivec4> rects;
+			Unigine::Math::ivec2 atlasSize;
+			const bool isValid = TextureAtlas::pack(sizes, 1024, padding, rects, atlasSize) && TextureAtlas::validatePacking(rects, atlasSize, padding);
+
+			fprintf(stderr, "atlas packing: %zu sizes, padding %d, %dx%d, %s\n", sizes.size(), padding, atlasSize.x, atlasSize.y, isValid ? "valid" : "invalid");
+			isPacked &= isValid;
+		}
+
+		// padded cells touching each other have to be rejected
+		const std::vector<Unigine::Math::ivec4> overlapping = { { 1, 1, 8, 8 }, { 10, 1, 8, 8 } };
+		isPacked &= !TextureAtlas::validatePacking(overlapping, Unigine::Math::ivec2(32, 32), 1);
+
+		TextureAtlas& atlas = TextureAtlas::get();
+		const std::vector<Unigine::String> textures = { "border.png", "tick.png", "pixels.png" };
+		const std::vector<Unigine::ImagePtr> images = { createPatternImage(24, 24, 1), createPatternImage(16, 12, 2), createPatternImage(7, 30, 3) };
+		const bool isBuilt = atlas.build(textures, images, 256, 2) && atlas.validate();
+
+		bool isSampled = false;
+		if (isBuilt)
+		{
+			const std::shared_ptr<CheckBox> checkBox = CheckBox::create();
+			const Unigine::WidgetSpritePtr sprite = Unigine::static_ptr_cast<Unigine::WidgetSprite>(checkBox->getWidget());
+
+			isSampled = sprite->getLayerTexCoord(0) == atlas.getRegion("border.png").texCoord &&
+				sprite->getLayerTexCoord(sprite->getNumLayers() - 1) == atlas.getRegion("tick.png").texCoord;
+		}
+
+		fprintf(stderr, "atlas: %zu regions %s, CheckBox %s\n", textures.size(), isBuilt ? "valid" : "invalid",
+			isSampled ? "samples its regions" : "doesn't sample its regions");
+
+		atlas.clear();
+		return isPacked && isBuilt && isSampled;
+	}
+
+	// Records a few layout passes at different resolutions, noMoPiReplay has to reproduce them exactly
+	bool saveTrace(const Scenario& scenario, const char* path)
+	{
+		Unigine::GuiPtr gui = standIn::createGui(1920, 1080);
+		UI ui(gui);
+		ui.setRootWidget(scenario.build());
+
+		ui.startTrace();
+
+		const Unigine::Math::ivec2 sizes[] = { { 1920, 1080 }, { 1280, 720 }, { 2560, 1440 }, { 800, 1280 } };
+		for (const Unigine::Math::ivec2& size : sizes)
+		{
+			standIn::setGuiSize(gui, size.x, size.y);
+			ui.updateLayout();
+		}
+
+		return ui.stopTrace(path);
+	}
+
+	void writeJson(FILE* file, const std::vector<Result>& results, int32_t iterations)
+	{
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+
+		fprintf(file, "{\n\t\"backend\": \"stand-in\",\n\t\"iterations\": %d,\n", iterations);
+		fprintf(file, "\t\"peakHeapBytes\": %zu,\n\t\"peakRssKilobytes\": %ld,\n", standIn::getAllocationCounters().peakBytes, usage.ru_maxrss);
+		fprintf(file, "\t\"scenarios\": [\n");
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			fprintf(file, "\t\t{\n\t\t\t\"name\": \"%s\",\n\t\t\t\"widgets\": %zu,\n\t\t\t\"engineObjects\": %u,\n\t\t\t\"hitTestMismatches\": %d,\n",
+				result.scenario, result.widgetCount, result.engineObjectCount, result.hitTestMismatchCount);
+			fprintf(file, "\t\t\t\"operations\": [\n");
+
+			for (size_t j = 0; j < result.measurements.size(); j++)
+			{
+				const Measurement& m = result.measurements[j];
+				fprintf(file, "\t\t\t\t{ \"name\": \"%s\", \"iterations\": %d, \"nsPerOp\": %.1f, \"minNs\": %.1f, \"allocationsPerOp\": %.2f, \"bytesPerOp\": %.1f, \"peakBytes\": %zu }%s\n",
+					m.operation, m.iterations, m.nsPerOp, m.minNs, m.allocationsPerOp, m.bytesPerOp, m.peakBytes, j + 1 < result.measurements.size() ? "," : "");
+			}
+
+			fprintf(file, "\t\t\t]\n\t\t}%s\n", i + 1 < results.size() ? "," : "");
+		}
+
+		fprintf(file, "\t]\n}\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t iterations = 200;
+	const char* output = nullptr;
+	const char* filter = nullptr;
+	const char* tracePath = nullptr;
+	bool isTickCheck = false;
+	bool isPreloadCheck = false;
+	bool isAtlasCheck = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+			iterations = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+			output = argv[++i];
+		else if (!strcmp(argv[i], "--scenario") && i + 1 < argc)
+			filter = argv[++i];
+		else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+			tracePath = argv[++i];
+		else if (!strcmp(argv[i], "--check-tick-allocations"))
+			isTickCheck = true;
+		else if (!strcmp(argv[i], "--check-texture-preload"))
+			isPreloadCheck = true;
+		else if (!strcmp(argv[i], "--check-atlas"))
+			isAtlasCheck = true;
+		else
+		{
+			fprintf(stderr, "usage: %s [--iterations count] [--output file.json] [--scenario name] [--check-tick-allocations] [--check-texture-preload] [--check-atlas] [--trace file.nmpt]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const Scenario scenarios[] = {
+		{ "deepNesting", buildDeepNesting },
+		{ "wideHBox", buildWideHBox },
+		{ "labelPanel", buildLabelPanel },
+		{ "bigScrollBox", buildBigScrollBox },
+		{ "describedScreen", buildDescribedScreen },
+		{ "compiledScreen", buildCompiledScreen },
+		{ "checkBoxGrid", buildCheckBoxGrid },
+	};
+
+	if (tracePath)
+	{
+		for (const Scenario& scenario : scenarios)
+		{
+			if (filter && !strcmp(filter, scenario.name))
+				return saveTrace(scenario, tracePath) ? 0 : 1;
+		}
+
+		fprintf(stderr, "noMoPiBenchmarks: --trace needs one --scenario to record\n");
+		return 1;
+	}
+
+	if (isPreloadCheck)
+		return checkTexturePreload() ? 0 : 2;
+
+	if (isAtlasCheck)
+		return checkAtlas() ? 0 : 2;
+
+	if (isTickCheck)
+	{
+		standIn::setAllocationHook(AllocationTracker::onAllocate);
+		AllocationTracker::get().setEnabled(true);
+
+		bool isPassed = true;
+		for (const Scenario& scenario : scenarios)
+		{
+			if (!filter || !strcmp(filter, scenario.name))
+				isPassed &= checkTickAllocations(scenario, iterations);
+		}
+
+		return isPassed ? 0 : 2;
+	}
+
+	std::vector<Result> results;
+	for (const Scenario& scenario : scenarios)
+	{
+		if (!filter || !strcmp(filter, scenario.name))
+			results.push_back(run(scenario, iterations));
+	}
+
+	if (results.empty())
+	{
+		fprintf(stderr, "noMoPiBenchmarks: unknown scenario \"%s\"\n", filter);
+		return 1;
+	}
+
+	FILE* file = output ? fopen(output, "w") : stdout;
+	if (!file)
+	{
+		fprintf(stderr, "noMoPiBenchmarks: can't write \"%s\"\n", output);
+		return 1;
+	}
+
+	writeJson(file, results, iterations);
+
+	if (file != stdout)
+		fclose(file);
+
+	return 0;
+}
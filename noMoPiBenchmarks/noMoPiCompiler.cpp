@@ -0,0 +1,129 @@
+#include "StandInBackend.h"
+#include "noMorePixels/noMorePixels.h"
+#include <cstdio>
+#include <cstring>
+#include <typeinfo>
+#include <vector>
+
+using namespace noMoPi;
+
+namespace
+{
+	// Widgets of a tree depth first, the order both loaders create them in
+	void collectWidgets(const std::shared_ptr<WidgetBase>& root, std::vector<WidgetBase*>& widgets)
+	{
+		std::vector<WidgetBase*> stack = { root.get() };
+		while (!stack.empty())
+		{
+			WidgetBase* widget = stack.back();
+			stack.pop_back();
+			widgets.push_back(widget);
+
+			if (const WidgetContainer* container = dynamic_cast<const WidgetContainer*>(widget))
+			{
+				const auto& children = container->getChildren();
+				for (auto it = children.rbegin(); it != children.rend(); ++it)
+					stack.push_back(it->get());
+			}
+		}
+	}
+
+	bool readFile(const char* path, std::vector<char>& text)
+	{
+		FILE* file = fopen(path, "rb");
+		if (!file)
+			return false;
+
+		char buffer[4096];
+		size_t size = 0;
+		while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			text.insert(text.end(), buffer, buffer + size);
+
+		fclose(file);
+		text.push_back('\0');
+		return true;
+	}
+
+	// Lays out the source and the compiled description and compares the type and rect of every widget
+	bool verify(const char* sourcePath, const char* outputPath)
+	{
+		Unigine::GuiPtr gui = standIn::createGui(1920, 1080);
+
+		std::vector<char> text;
+		UIDescription source;
+		if (!readFile(sourcePath, text) || !source.parse(text.data()))
+			return false;
+
+		MappedFile mapped;
+		UIDescription compiled;
+		if (!mapped.open(outputPath) || !compiled.instantiate(mapped.getData(), mapped.getSize(), outputPath))
+			return false;
+
+		std::vector<WidgetBase*> sourceWidgets, compiledWidgets;
+		const std::shared_ptr<WidgetBase> roots[] = { source.getRoot(), compiled.getRoot() };
+		for (const std::shared_ptr<WidgetBase>& root : roots)
+		{
+			UI ui(gui);
+			ui.setRootWidget(root);
+			ui.updateLayout();
+		}
+
+		collectWidgets(source.getRoot(), sourceWidgets);
+		collectWidgets(compiled.getRoot(), compiledWidgets);
+		if (sourceWidgets.size() != compiledWidgets.size())
+		{
+			fprintf(stderr, "noMoPiCompiler: %s has %zu widgets, the source %zu\n", outputPath, compiledWidgets.size(), sourceWidgets.size());
+			return false;
+		}
+
+		for (size_t i = 0; i < sourceWidgets.size(); i++)
+		{
+			if (typeid(*sourceWidgets[i]) != typeid(*compiledWidgets[i]) || sourceWidgets[i]->getLayoutRect() != compiledWidgets[i]->getLayoutRect())
+			{
+				fprintf(stderr, "noMoPiCompiler: widget %zu of %s differs from the source\n", i, outputPath);
+				return false;
+			}
+		}
+
+		printf("%s: %zu widgets match the source\n", outputPath, compiledWidgets.size());
+		return true;
+	}
+}
+
+// Compiles a UI description to the blob UIDescription::loadCompiled maps. --verify compares the layouts of both
+// on the stand-in backend, --default-font adds the fonts the game registers before loading.
+int main(int argc, char** argv)
+{
+	const char* sourcePath = nullptr;
+	const char* outputPath = nullptr;
+	bool isVerifying = false;
+	bool isUsageError = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--verify"))
+			isVerifying = true;
+		else if (!strcmp(argv[i], "--default-font") && i + 1 < argc)
+			Settings::get().addDefaultFont(argv[++i]);
+		else if (!sourcePath && argv[i][0] != '-')
+			sourcePath = argv[i];
+		else if (!outputPath && argv[i][0] != '-')
+			outputPath = argv[i];
+		else
+			isUsageError = true;
+	}
+
+	if (!sourcePath || !outputPath || isUsageError)
+	{
+		fprintf(stderr, "usage: %s source.xml output.nmpu [--verify] [--default-font file.ttf]\n", argv[0]);
+		return 1;
+	}
+
+	if (!UIDescription::compile(sourcePath, outputPath))
+		return 1;
+
+	if (isVerifying && !verify(sourcePath, outputPath))
+		return 2;
+
+	return 0;
+}
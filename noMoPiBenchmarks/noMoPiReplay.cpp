@@ -0,0 +1,139 @@
+#include "StandInBackend.h"
+#include "noMorePixels/noMorePixels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace noMoPi;
+
+// Replays a trace saved by UI::stopTrace on the stand-in backend, recorded text measurements stand in for the
+// fonts so every pass has to reproduce the recorded rects and font sizes. --sliced plans passes as a LayoutJob.
+int main(int argc, char** argv)
+{
+	const char* path = nullptr;
+	int32_t repeat = 1;
+	int32_t filter = -1;
+	long long sliceMicroseconds = 0;
+	bool isUsageError = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--pass") && i + 1 < argc)
+			filter = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--sliced") && i + 1 < argc)
+			sliceMicroseconds = std::max(1, atoi(argv[++i]));
+		else if (!path && argv[i][0] != '-')
+			path = argv[i];
+		else
+			isUsageError = true;
+	}
+
+	if (!path || isUsageError)
+	{
+		fprintf(stderr, "usage: %s trace.nmpt [--repeat count] [--pass index] [--sliced microseconds]\n", argv[0]);
+		return 1;
+	}
+
+	LayoutTrace trace;
+	if (!trace.load(path))
+		return 1;
+
+	trace.applyFontSizePolicy();
+
+	Unigine::GuiPtr gui = standIn::createGui(1920, 1080);
+	UI ui(gui);
+	LayoutJob job;
+
+	using Clock = std::chrono::steady_clock;
+
+	int32_t currentTree = -1;
+	std::vector<std::shared_ptr<WidgetBase>> nodes;
+
+	int32_t replayedCount = 0;
+	int32_t mismatchedCount = 0;
+	int32_t slowestPass = -1;
+	double slowestNs = 0.0;
+
+	for (int32_t i = 0; i < static_cast<int32_t>(trace.passes.size()); i++)
+	{
+		if (filter >= 0 && i != filter)
+			continue;
+
+		const LayoutTrace::Pass& pass = trace.passes[i];
+		if (pass.tree != currentTree)
+		{
+			nodes = trace.buildTree(pass.tree);
+			currentTree = pass.tree;
+
+			if (!nodes.empty())
+				ui.setRootWidget(nodes.front());
+		}
+
+		if (nodes.empty())
+		{
+			printf("pass %d: empty tree, skipped\n", i);
+			continue;
+		}
+
+		standIn::setGuiSize(gui, pass.guiSize.x, pass.guiSize.y);
+
+		double minNs = std::numeric_limits<double>::max();
+		double totalNs = 0.0;
+		int32_t stepCount = 0;
+		for (int32_t j = 0; j < repeat; j++)
+		{
+			trace.beginReplay(i);
+			const Clock::time_point begin = Clock::now();
+			if (sliceMicroseconds)
+			{
+				stepCount = 0;
+				job.start(nodes.front(), pass.guiSize.x, pass.guiSize.y);
+				while (!job.step(sliceMicroseconds))
+					stepCount++;
+
+				stepCount++;
+				job.commit();
+			}
+			else
+				ui.updateLayout();
+			const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+			trace.endReplay();
+
+			minNs = std::min(minNs, ns);
+			totalNs += ns;
+		}
+
+		const int32_t mismatchCount = trace.compareResults(i, nodes);
+		printf("pass %d: %dx%d, %zu nodes, %zu measurements, %.1f us min, %.1f us mean, %d mismatches", i, pass.guiSize.x, pass.guiSize.y,
+			nodes.size(), pass.measurements.size(), minNs / 1000.0, totalNs / repeat / 1000.0, mismatchCount);
+		if (sliceMicroseconds)
+			printf(", %d steps", stepCount);
+		printf("\n");
+
+		replayedCount++;
+		if (mismatchCount)
+			mismatchedCount++;
+
+		if (minNs > slowestNs)
+		{
+			slowestNs = minNs;
+			slowestPass = i;
+		}
+	}
+
+	if (!replayedCount)
+	{
+		fprintf(stderr, "noMoPiReplay: no pass to replay in \"%s\"\n", path);
+		return 1;
+	}
+
+	printf("%d passes replayed, %d differ from the recording, slowest is pass %d at %.1f us\n", replayedCount, mismatchedCount, slowestPass, slowestNs / 1000.0);
+
+	return mismatchedCount ? 2 : 0;
+}
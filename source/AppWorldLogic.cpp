@@ -1,6 +1,7 @@
 #include "AppWorldLogic.h"
 #include "noMorePixels/noMorePixels.h"
 #include <UnigineUserInterface.h>
+#include <UnigineEngine.h>
 
 AppWorldLogic::AppWorldLogic()
 {}
@@ -16,78 +17,22 @@ int AppWorldLogic::init()
 
 	if (gui)
 	{
-		static UI ui(gui);
+		_ui = std::make_unique<UI>(gui);
 
 		Settings::get().addDefaultFont("Roboto-Regular.ttf");
-
-		auto hbox = HBox::create();
-		hbox->setBackgroundEnabled(true)
-			->setBackgroundTexture("3dMenuBackground.png")
-			->setBackgroundTextureFiltering(Unigine::Texture::SAMPLER_FILTER_POINT)
-			->setBackgroundColor(50, 50, 50)
-			->setPadding(0.05f, 0.05f, 0.05f, 0.05f)
-			->setPaddingEqual(true)
-			->setSpacing(0.05f);
-
-		if (hbox)
-			ui.setRootWidget(hbox);
-
-		auto vbox1 = VBox::create();
-		vbox1->setBackgroundEnabled(true)
-			->setBackgroundColor(255, 0, 0);
-
-
-		auto vbox2 = VBox::create();
-		vbox2->setBackgroundEnabled(true)
-			->setBackgroundColor(0, 255, 0);
-
-		auto vboxsquare = VBox::create();
-		vbox2->setBackgroundEnabled(true)
-			->setBackgroundColor(0, 0, 255);
-
-		auto label = Label::create(ScaleSettings(ScaleType::Proportional, 0.1f));
-		label->setText("Source string")
-			->setDefaultFont(0)
-			->setTextAlign(Align::Center, Align::Top);
-
-		auto edit = EditLine::create();
-		edit->setDefaultFont(0);
-
-		auto check = CheckBox::create();
-		
-		auto scrollbox = ScrollBox::create();
-		scrollbox->setVisibleItemCount(2);
-
-		auto vbox1scroll = VBox::create();
-		vbox1scroll->setBackgroundEnabled(true)
-			->setBackgroundColor(255, 0, 0);
-
-		auto vbox2scroll = VBox::create();
-		vbox2scroll->setBackgroundEnabled(true)
-			->setBackgroundColor(0, 255, 0);
-
-		auto vbox3scroll = VBox::create();
-		vbox3scroll->setBackgroundEnabled(true)
-			->setBackgroundColor(255, 0, 0);
-
-		scrollbox->addChild(vbox1scroll);
-		scrollbox->addChild(vbox2scroll);
-		scrollbox->addChild(vbox3scroll);
-
-		vbox1->addChild(vboxsquare);
-		vbox1->addChild(edit);
-		vbox1->addChild(check);
-		
-		vbox2->addChild(label);
-		vbox2->addChild(scrollbox);
-
-		hbox->addChild(vbox1);
-		hbox->addChild(vbox2);
-
-		ui.updateLayout();
-		//ui.setDictionary("test.xml");
-		//ui.setLanguage("en");
-		//ui.translate();
+		TextureAtlas::get().build({ "border.png", "tick.png" });
+
+		// edits to layouts/demo.xml show up on the next start without a rebuild
+		UIDescription description;
+		if (description.load("demo.xml"))
+		{
+			_ui->setRootWidget(description.getRoot());
+			_ui->updateLayout();
+		}
+
+		//_ui->setDictionary("test.xml");
+		//_ui->setLanguage("en");
+		//_ui->translate();
 		
 	}
 
@@ -96,6 +41,9 @@ int AppWorldLogic::init()
 
 int AppWorldLogic::update()
 {
+	if (_ui)
+		_ui->tick(Unigine::Engine::get()->getIFps());
+
 	return 1;
 }
 
@@ -111,6 +59,11 @@ int AppWorldLogic::updatePhysics()
 
 int AppWorldLogic::shutdown()
 {
+	_ui.reset();
+	WidgetRecycler::get().clear();
+	TextureAtlas::get().clear();
+	TextureCache::get().clear();
+
 	return 1;
 }
 
@@ -3,6 +3,9 @@
 
 #include <UnigineLogic.h>
 #include <UnigineStreams.h>
+#include <memory>
+
+namespace noMoPi { class UI; }
 
 class AppWorldLogic : public Unigine::WorldLogic
 {
@@ -21,6 +24,9 @@ public:
 
 	int save(const Unigine::StreamPtr &stream) override;
 	int restore(const Unigine::StreamPtr &stream) override;
+
+private:
+	std::unique_ptr<noMoPi::UI> _ui;
 };
 
 #endif // __APP_WORLD_LOGIC_H__
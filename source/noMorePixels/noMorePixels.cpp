@@ -1,130 +1,548 @@
 #include "noMorePixels.h"
 #include <UnigineEngine.h>
+#include <UnigineLog.h>
+#include <UnigineAsyncQueue.h>
+#include <UnigineXml.h>
+#include <UnigineJson.h>
+#include <UnigineTimer.h>
+#include <UnigineMathLibRandom.h>
+#include <UnigineChecksum.h>
+#include <UnigineFileSystem.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+// typeid names are mangled everywhere but on MSVC
+#ifndef _MSC_VER
+	#include <cxxabi.h>
+	#include <cstdlib>
+#endif
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// Define NOMOPI_PROFILER to show noMoPi passes and per-frame counters in Unigine::Profiler, everything compiles out otherwise
+#ifdef NOMOPI_PROFILER
+	#include <UnigineProfiler.h>
+
+	#define NOMOPI_PROFILER_SCOPED(NAME) UNIGINE_PROFILER_SCOPED(NAME)
+#else
+	#define NOMOPI_PROFILER_SCOPED(NAME)
+#endif
 
 using namespace noMoPi;
 
+// Singletons widgets release into are constructed first, so static destruction runs them down after the UI
+UI::UI()
+{
+	TextureCache::get();
+	ConnectionPool::get();
+}
+
+UI::UI(const Unigine::GuiPtr& gui) : UI()
+{
+	_gui = gui;
+}
+
 void UI::setRootWidget(const std::shared_ptr<WidgetBase>& widget)
 {
 	_rootWidget = widget;
+	_layoutJob.cancel();
 	_rootWidget->setGui(_gui);
 	_gui->addChild(*_rootWidget);
 }
 
 void UI::updateLayout()
 {
+	NOMOPI_PROFILER_SCOPED(_profilerName.get());
+	NOMOPI_PROFILER_SCOPED("noMoPi::UI::updateLayout");
+	AllocationScope allocationScope(AllocationTracker::Operation::UpdateLayout);
+
+	_isLayoutRequested = false;
+	_layoutJob.cancel();
+
+	if (!_rootWidget)
+		return;
+
 	Unigine::Math::ivec2 guiSize = _gui->getSize();
-	_rootWidget->resize(guiSize.x, guiSize.y);
+
+	if (_trace)
+		_trace->beginPass(_rootWidget, guiSize);
+
+	const long long begin = Unigine::Time::get();
+
+	{
+		FrameBudgetScope budgetScope(*_rootWidget, _frameBudgetMicroseconds > 0);
+		_rootWidget->resize(guiSize.x, guiSize.y);
+	}
+
+	const long long microseconds = Unigine::Time::get() - begin;
+	_layoutMicroseconds += microseconds;
+
+	if (_trace)
+		_trace->endPass();
+
+	_resizeOverlay(guiSize);
+	_checkFrameBudget("updateLayout", microseconds);
+}
+
+void UI::_resizeOverlay(const Unigine::Math::ivec2& guiSize)
+{
+	if (!_overlay)
+		return;
+
+	const FrameCounters counters = FrameCounters::getCurrent();
+	_overlay->resize(guiSize.x, guiSize.y);
+	FrameCounters::getCurrent() = counters;
+}
+
+void UI::_spreadLayout(long long frameBegin)
+{
+	NOMOPI_PROFILER_SCOPED("noMoPi::UI::_spreadLayout");
+
+	const long long begin = Unigine::Time::get();
+
+	if (_isLayoutRequested)
+	{
+		_isLayoutRequested = false;
+
+		const Unigine::Math::ivec2 guiSize = _gui->getSize();
+		_layoutJob.start(_rootWidget, guiSize.x, guiSize.y);
+	}
+
+	if (_layoutJob.step(_frameBudgetMicroseconds - (begin - frameBegin)))
+	{
+		_layoutJob.commit();
+		_resizeOverlay(_gui->getSize());
+	}
+
+	const long long microseconds = Unigine::Time::get() - begin;
+	_layoutMicroseconds += microseconds;
+
+	_checkFrameBudget("spread layout", microseconds);
+}
+
+void UI::setLayoutSpreading(bool isSpreading)
+{
+	_isLayoutSpreading = isSpreading;
+
+	if (!isSpreading && _layoutJob.isRunning())
+	{
+		_layoutJob.cancel();
+		_isLayoutRequested = true;
+	}
+}
+
+void UI::setFrameBudget(float milliseconds)
+{
+	_frameBudgetMicroseconds = static_cast<long long>(std::max(milliseconds, 0.f) * 1000.f);
+	_frameMicroseconds = 0;
+	_overBudgetFrameCount = 0;
+	_isOverBudget = false;
+}
+
+// Demangled once per type, the pointer stays valid
+static const char* getTypeName(const std::type_info& type)
+{
+	static std::deque<Unigine::String> names;
+	static Unigine::HashMap<const std::type_info*, const char*> cache;
+
+	auto it = cache.find(&type);
+	if (it != cache.end())
+		return it->data;
+
+	Unigine::String& name = names.emplace_back();
+#ifdef _MSC_VER
+	const char* rawName = type.name();
+	for (const char* keyword : { "class ", "struct " })
+	{
+		if (!strncmp(rawName, keyword, strlen(keyword)))
+		{
+			rawName += strlen(keyword);
+			break;
+		}
+	}
+
+	name = rawName;
+#else
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+	name = status == 0 && demangled ? demangled : type.name();
+	free(demangled);
+#endif
+
+	cache.append(&type, name.get());
+	return name.get();
+}
+
+static const char* getShortTypeName(const WidgetBase& widget)
+{
+	const char* name = getTypeName(typeid(widget));
+	for (const char* c = name; *c; c++)
+	{
+		if (*c == ':' || *c == ' ')
+			name = c + 1;
+	}
+
+	return name;
+}
+
+void UI::_checkFrameBudget(const char* phase, long long microseconds)
+{
+	if (_frameBudgetMicroseconds <= 0)
+		return;
+
+	if (!_isTicking)
+		_frameMicroseconds += microseconds;
+
+	const long long frameMicroseconds = _isTicking ? _frameMicroseconds + microseconds : _frameMicroseconds;
+	if (frameMicroseconds <= _frameBudgetMicroseconds || _isOverBudget || !_rootWidget)
+		return;
+
+	_isOverBudget = true;
+	_overBudgetFrameCount++;
+
+	// descend while one child took most of its parent's time, below that the cost is spread over siblings
+	const WidgetBase* node = _rootWidget.get();
+	Unigine::String path = getShortTypeName(*node);
+	while (const WidgetContainer* container = dynamic_cast<const WidgetContainer*>(node))
+	{
+		const auto& children = container->getChildren();
+		int32_t slowest = -1;
+		for (int32_t i = 0; i < static_cast<int32_t>(children.size()); i++)
+		{
+			if (slowest < 0 || children[i]->getPassMicroseconds() > children[slowest]->getPassMicroseconds())
+				slowest = i;
+		}
+
+		if (slowest < 0 || children[slowest]->getPassMicroseconds() * 2 < node->getPassMicroseconds())
+			break;
+
+		char index[16];
+		snprintf(index, sizeof(index), "[%d]", slowest);
+
+		node = children[slowest].get();
+		path += "/";
+		path += getShortTypeName(*node);
+		path += index;
+	}
+
+	Unigine::Log::warning("noMoPi: %s %s took %.2f ms, %.2f ms this frame over a %.2f ms budget, slowest subtree %s took %.2f ms\n",
+		_profilerName.get(), phase, Unigine::Time::microsecondsToMilliseconds(microseconds), Unigine::Time::microsecondsToMilliseconds(frameMicroseconds),
+		Unigine::Time::microsecondsToMilliseconds(_frameBudgetMicroseconds), path.get(), Unigine::Time::microsecondsToMilliseconds(node->getPassMicroseconds()));
 }
 
 void noMoPi::UI::setDictionary(const char* dictionary)
 {
-	_currentDictionary = Settings::get().getLocalizationPath(dictionary);
+	_currentDictionary = Settings::get().getLocalizationId(dictionary);
 }
 
 void noMoPi::UI::setLanguage(const char* language)
 {
 	_gui->clearDictionaries();
-	_gui->addDictionary(_currentDictionary, language);
+	_gui->addDictionary(Settings::get().getPath(_currentDictionary), language);
 }
 
 void WidgetBase::resize(int32_t width, int32_t height)
 {
+	FrameCounters::getCurrent().widgetsLaidOut++;
+
 	_widget->setWidth(width);
 	_widget->setHeight(height);
+}
+
+void WidgetBase::collectFootprint(Footprint& footprint) const
+{
+	footprint.objectCount++;
+	footprint.bytes += sizeof(WidgetBase);
+
+	if (_widget)
+		footprint.engineWidgetCount++;
+}
+
+WidgetBase* WidgetBase::pick(int32_t x, int32_t y, bool useIndex)
+{
+	return _isInteractive ? this : nullptr;
+}
 
-	if (Interactive* interactive = dynamic_cast<Interactive*>(this))
-		interactive->resize(width, height);
+void WidgetBase::pickRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<RayHit>& hits)
+{
+	if (!_isInteractive)
+		return;
+
+	float distance = 0.f;
+	const Unigine::Math::vec2 inverseDirection(1.f / direction.x, 1.f / direction.y);
+	if (SpatialIndex::intersectRay(Unigine::Math::ivec4(0, 0, _widget->getWidth(), _widget->getHeight()), origin, inverseDirection, distance))
+		hits.push_back({ this, distance });
 }
 
 void WidgetContainer::resize(int32_t width, int32_t height)
+{
+	_beginResize(width, height);
+	_resizeChildren();
+	_placeChildren();
+}
+
+void WidgetContainer::_beginResize(int32_t width, int32_t height)
 {
 	WidgetBase::resize(width, height);
 
 	_calculatePadding();
 	_calculateSpacing();
-
-	_resizeChildren();
+	_updateNineSlice();
 }
 
-void noMoPi::WidgetContainer::_resizeChildren()
+void WidgetContainer::_placeChildren()
 {
-	float totalWidgetsWeight = 0.f;
-	int32_t fillWidgetsCount = 0;
-	int32_t otherWidgetsCount = 0;
+	const bool isHorizontal = _widget->getType() == Unigine::Widget::TYPE::WIDGET_HBOX;
+
+	int32_t x = _isPaddingEqual ? _paddingInPixels.min() : _paddingInPixels[std::to_underlying(Padding::Left)];
+	int32_t y = _isPaddingEqual ? _paddingInPixels.min() : _paddingInPixels[std::to_underlying(Padding::Top)];
+
+	int32_t spacing = 0;
+	if (!_spacers.empty())
+		spacing = isHorizontal ? _spacers.front()->getWidth() : _spacers.front()->getHeight();
+
+	_childRects.clear();
+
+	_containsInteractive = _isInteractive;
 
 	for (auto& child : _childWidgets)
 	{
-		if (child->getScaleSettings().scaleType == ScaleType::Fill)
+		child->setLayoutPosition(x, y);
+		_containsInteractive |= child->containsInteractive();
+
+		const Unigine::Math::ivec4 rect = child->getLayoutRect();
+		if (isHorizontal)
+			x += rect.z + spacing;
+		else
+			y += rect.w + spacing;
+
+		if (_childWidgets.size() >= _spatialIndexThreshold)
+			_childRects.push_back(rect);
+	}
+
+	if (_childRects.empty())
+		_childIndex.clear();
+	else if (_childIndex.getCount() == _childRects.size())
+		_childIndex.refit(_childRects);
+	else
+		_childIndex.build(_childRects);
+}
+
+WidgetBase* WidgetContainer::pick(int32_t x, int32_t y, bool useIndex)
+{
+	if (!_containsInteractive)
+		return nullptr;
+
+	const Unigine::Math::ivec2 scroll = _getScrollOffset();
+	const int32_t contentX = x + scroll.x;
+	const int32_t contentY = y + scroll.y;
+
+	if (useIndex && !_childIndex.isEmpty())
+	{
+		_pickCandidates.clear();
+		_childIndex.queryPoint(contentX, contentY, _pickCandidates);
+
+		std::sort(_pickCandidates.begin(), _pickCandidates.end(), std::greater<int32_t>());
+
+		for (int32_t index : _pickCandidates)
 		{
-			totalWidgetsWeight += child->getScaleSettings().scaleFactor;
-			fillWidgetsCount++;
+			const Unigine::Math::ivec4 rect = _childWidgets[index]->getLayoutRect();
+			if (WidgetBase* target = _childWidgets[index]->pick(contentX - rect.x, contentY - rect.y, useIndex))
+				return target;
 		}
-		else
-			otherWidgetsCount++;
+
+		return WidgetBase::pick(x, y, useIndex);
+	}
+
+	for (auto it = _childWidgets.rbegin(); it != _childWidgets.rend(); ++it)
+	{
+		const Unigine::Math::ivec4 rect = (*it)->getLayoutRect();
+		const int32_t childX = contentX - rect.x;
+		const int32_t childY = contentY - rect.y;
+
+		if (childX < 0 || childY < 0 || childX >= rect.z || childY >= rect.w)
+			continue;
+
+		if (WidgetBase* target = (*it)->pick(childX, childY, useIndex))
+			return target;
 	}
 
-	int32_t parentWidth = getInnerWidth();
-	int32_t parentHeight = getInnerHeight();
+	return WidgetBase::pick(x, y, useIndex);
+}
+
+void WidgetContainer::pickRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<RayHit>& hits)
+{
+	if (!_containsInteractive)
+		return;
 
-	bool isHorizontal = _widget->getType() == Unigine::Widget::TYPE::WIDGET_HBOX;
+	const Unigine::Math::ivec2 scroll = _getScrollOffset();
+	const Unigine::Math::vec2 contentOrigin = origin + Unigine::Math::vec2(static_cast<float>(scroll.x), static_cast<float>(scroll.y));
 
-	if (isHorizontal)
+	if (!_childIndex.isEmpty())
 	{
-		uint32_t spacing = static_cast<int32_t>(_spacing * parentWidth);
-		parentWidth -= spacing * (static_cast<int32_t>(_childWidgets.size()) - 1);
+		_rayCandidates.clear();
+		_childIndex.queryRay(contentOrigin, direction, _rayCandidates);
+
+		for (const auto& candidate : _rayCandidates)
+		{
+			const Unigine::Math::ivec4 rect = _childWidgets[candidate.index]->getLayoutRect();
+			_childWidgets[candidate.index]->pickRay(contentOrigin - Unigine::Math::vec2(static_cast<float>(rect.x), static_cast<float>(rect.y)), direction, hits);
+		}
 	}
 	else
 	{
-		uint32_t spacing = static_cast<int32_t>(_spacing * parentHeight);
-		parentHeight -= spacing * (static_cast<int32_t>(_childWidgets.size()) - 1);
+		const Unigine::Math::vec2 inverseDirection(1.f / direction.x, 1.f / direction.y);
+
+		for (auto& child : _childWidgets)
+		{
+			const Unigine::Math::ivec4 rect = child->getLayoutRect();
+
+			float distance = 0.f;
+			if (SpatialIndex::intersectRay(Unigine::Math::ivec4(rect.x, rect.y, rect.x + rect.z, rect.y + rect.w), contentOrigin, inverseDirection, distance))
+				child->pickRay(contentOrigin - Unigine::Math::vec2(static_cast<float>(rect.x), static_cast<float>(rect.y)), direction, hits);
+		}
+	}
+
+	WidgetBase::pickRay(origin, direction, hits);
+}
+
+void noMoPi::WidgetContainer::_resizeChildren()
+{
+	NOMOPI_PROFILER_SCOPED("noMoPi::WidgetContainer::_resizeChildren");
+
+	ChildSizing sizing = _beginChildSizing(Unigine::Math::ivec2(getWidth(), getHeight()), _paddingInPixels);
+	for (auto& child : _childWidgets)
+	{
+		Unigine::Math::ivec2 size;
+		if (!_nextChildSize(sizing, *child, size))
+			continue;
+
+		FrameBudgetScope budgetScope(*child);
+		child->resize(size.x, size.y);
 	}
+}
+
+void WidgetContainer::planLayout(LayoutJob& job, LayoutRecord& record)
+{
+	record.isContainer = true;
+
+	_planChildren(job, record.width, record.height);
+}
 
-	int32_t spaceLeft = isHorizontal ? parentWidth : parentHeight;
+void WidgetContainer::commitLayout(const LayoutRecord& record)
+{
+	_beginResize(record.width, record.height);
+}
+
+void WidgetContainer::_planChildren(LayoutJob& job, int32_t width, int32_t height)
+{
+	const Unigine::Math::ivec2 size(width, height);
+
+	ChildSizing sizing = _beginChildSizing(size, _calculatePaddingInPixels(width, height));
 	for (auto& child : _childWidgets)
 	{
-		const ScaleType& scaleType = child->getScaleSettings().scaleType;
-		if (scaleType == ScaleType::Fill)
-		{
-			int32_t childSize = isHorizontal ?
-				fillWidgetsCount > 1 ? static_cast<int32_t>(parentWidth * (child->getScaleSettings().scaleFactor / totalWidgetsWeight)) : spaceLeft :
-				fillWidgetsCount > 1 ? static_cast<int32_t>(parentHeight * (child->getScaleSettings().scaleFactor / totalWidgetsWeight)) : spaceLeft;
+		Unigine::Math::ivec2 childSize;
+		if (_nextChildSize(sizing, *child, childSize))
+			job.push(child, childSize.x, childSize.y);
+	}
+}
 
-			if (isHorizontal)
-				child->resize(childSize, parentHeight);
-			else
-				child->resize(parentWidth, childSize);
+WidgetContainer::ChildSizing WidgetContainer::_beginChildSizing(const Unigine::Math::ivec2& size, const Unigine::Math::ivec4& paddingInPixels) const
+{
+	ChildSizing sizing;
 
-			spaceLeft -= childSize;
-			fillWidgetsCount--;
-		}
-		else if (scaleType == ScaleType::Proportional)
+	for (auto& child : _childWidgets)
+	{
+		if (child->getScaleSettings().scaleType == ScaleType::Fill)
 		{
-			int32_t childSize = isHorizontal ?
-				static_cast<int32_t>(parentHeight * child->getScaleSettings().scaleFactor) :
-				static_cast<int32_t>(parentWidth * child->getScaleSettings().scaleFactor);
+			sizing.totalWidgetsWeight += child->getScaleSettings().scaleFactor;
+			sizing.fillWidgetsCount++;
+		}
+	}
 
-			if (isHorizontal)
-				child->resize(childSize, parentHeight);
-			else
-				child->resize(parentWidth, childSize);
+	const Unigine::Math::ivec2 innerSize = _getInnerSize(size, paddingInPixels);
+	sizing.parentWidth = innerSize.x;
+	sizing.parentHeight = innerSize.y;
+	sizing.isHorizontal = _widget->getType() == Unigine::Widget::TYPE::WIDGET_HBOX;
 
-			spaceLeft -= childSize;
-		}
+	if (sizing.isHorizontal)
+	{
+		uint32_t spacing = static_cast<int32_t>(_spacing * sizing.parentWidth);
+		sizing.parentWidth -= spacing * (static_cast<int32_t>(_childWidgets.size()) - 1);
+	}
+	else
+	{
+		uint32_t spacing = static_cast<int32_t>(_spacing * sizing.parentHeight);
+		sizing.parentHeight -= spacing * (static_cast<int32_t>(_childWidgets.size()) - 1);
 	}
+
+	sizing.spaceLeft = sizing.isHorizontal ? sizing.parentWidth : sizing.parentHeight;
+	return sizing;
 }
 
-int32_t noMoPi::WidgetContainer::getInnerHeight() const
+bool WidgetContainer::_nextChildSize(ChildSizing& sizing, const WidgetBase& child, Unigine::Math::ivec2& size) const
 {
-	int32_t verticalPadding = _isPaddingEqual ? _paddingInPixels.min() * 2 : _paddingInPixels[std::to_underlying(Padding::Top)] + _paddingInPixels[std::to_underlying(Padding::Bottom)];
+	const ScaleSettings& scaleSettings = child.getScaleSettings();
+	const bool isHorizontal = sizing.isHorizontal;
+
+	int32_t childSize = 0;
+	if (scaleSettings.scaleType == ScaleType::Fill)
+	{
+		childSize = isHorizontal ?
+			sizing.fillWidgetsCount > 1 ? static_cast<int32_t>(sizing.parentWidth * (scaleSettings.scaleFactor / sizing.totalWidgetsWeight)) : sizing.spaceLeft :
+			sizing.fillWidgetsCount > 1 ? static_cast<int32_t>(sizing.parentHeight * (scaleSettings.scaleFactor / sizing.totalWidgetsWeight)) : sizing.spaceLeft;
+
+		sizing.fillWidgetsCount--;
+	}
+	else if (scaleSettings.scaleType == ScaleType::Proportional)
+	{
+		childSize = isHorizontal ?
+			static_cast<int32_t>(sizing.parentHeight * scaleSettings.scaleFactor) :
+			static_cast<int32_t>(sizing.parentWidth * scaleSettings.scaleFactor);
+	}
+	else
+		return false;
+
+	size = isHorizontal ? Unigine::Math::ivec2(childSize, sizing.parentHeight) : Unigine::Math::ivec2(sizing.parentWidth, childSize);
+	sizing.spaceLeft -= childSize;
 
-	return getHeight() - verticalPadding;
+	return true;
+}
+
+int32_t noMoPi::WidgetContainer::getInnerHeight() const
+{
+	return _getInnerSize(Unigine::Math::ivec2(getWidth(), getHeight()), _paddingInPixels).y;
 }
 
 int32_t noMoPi::WidgetContainer::getInnerWidth() const
 {
-	int32_t horizontalPadding = _isPaddingEqual ? _paddingInPixels.min() * 2 : _paddingInPixels[std::to_underlying(Padding::Left)] + _paddingInPixels[std::to_underlying(Padding::Right)];
+	return _getInnerSize(Unigine::Math::ivec2(getWidth(), getHeight()), _paddingInPixels).x;
+}
+
+Unigine::Math::ivec2 WidgetContainer::_getInnerSize(const Unigine::Math::ivec2& size, const Unigine::Math::ivec4& paddingInPixels) const
+{
+	int32_t horizontalPadding = _isPaddingEqual ? paddingInPixels.min() * 2 : paddingInPixels[std::to_underlying(Padding::Left)] + paddingInPixels[std::to_underlying(Padding::Right)];
+	int32_t verticalPadding = _isPaddingEqual ? paddingInPixels.min() * 2 : paddingInPixels[std::to_underlying(Padding::Top)] + paddingInPixels[std::to_underlying(Padding::Bottom)];
 
-	return getWidth() - horizontalPadding;
+	return Unigine::Math::ivec2(size.x - horizontalPadding, size.y - verticalPadding);
 }
 
 WidgetContainer* WidgetContainer::setPadding(float top, float bottom, float left, float right)
@@ -146,15 +564,20 @@ WidgetContainer* WidgetContainer::setSpacing(float spacing, bool ignorePadding)
 	return this;
 }
 
-void noMoPi::WidgetContainer::_calculatePadding()
+Unigine::Math::ivec4 WidgetContainer::_calculatePaddingInPixels(int32_t width, int32_t height) const
 {
-	const int32_t width = getWidth();
-	const int32_t height = getHeight();
+	Unigine::Math::ivec4 paddingInPixels;
+	paddingInPixels[std::to_underlying(Padding::Left)] = static_cast<int32_t>(width * _padding[std::to_underlying(Padding::Left)]);
+	paddingInPixels[std::to_underlying(Padding::Right)] = static_cast<int32_t>(width * _padding[std::to_underlying(Padding::Right)]);
+	paddingInPixels[std::to_underlying(Padding::Top)] = static_cast<int32_t>(height * _padding[std::to_underlying(Padding::Top)]);
+	paddingInPixels[std::to_underlying(Padding::Bottom)] = static_cast<int32_t>(height * _padding[std::to_underlying(Padding::Bottom)]);
 
-	_paddingInPixels[std::to_underlying(Padding::Left)] = static_cast<int32_t>(width * _padding[std::to_underlying(Padding::Left)]);
-	_paddingInPixels[std::to_underlying(Padding::Right)] = static_cast<int32_t>(width * _padding[std::to_underlying(Padding::Right)]);
-	_paddingInPixels[std::to_underlying(Padding::Top)] = static_cast<int32_t>(height * _padding[std::to_underlying(Padding::Top)]);
-	_paddingInPixels[std::to_underlying(Padding::Bottom)] = static_cast<int32_t>(height * _padding[std::to_underlying(Padding::Bottom)]);
+	return paddingInPixels;
+}
+
+void noMoPi::WidgetContainer::_calculatePadding()
+{
+	_paddingInPixels = _calculatePaddingInPixels(getWidth(), getHeight());
 
 	if (Unigine::WidgetVBoxPtr box = Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget))
 	{
@@ -202,10 +625,7 @@ HBox::HBox(const ScaleSettings& scaleSettings) : WidgetContainer(scaleSettings)
 {
 	_widget = Unigine::WidgetHBox::create();
 
-	if (Unigine::WidgetHBoxPtr hbox = Unigine::static_ptr_cast<Unigine::WidgetHBox>(_widget))
-	{
-		hbox->setBackgroundTexture(".noMorePixels/textures/white.png");
-	}
+	setBackgroundTexture(Settings::get().getWhiteBackgroundId());
 }
 
 void noMoPi::WidgetContainer::addChild(const std::shared_ptr<WidgetBase>& widget)
@@ -213,13 +633,6 @@ void noMoPi::WidgetContainer::addChild(const std::shared_ptr<WidgetBase>& widget
 	Unigine::GuiPtr gui = _widget->getGui();
 	widget->setGui(gui);
 
-	// Interactive vidgets support events like onClicked, onEnter, ect
-	if (Interactive* interactive = dynamic_cast<Interactive*>(widget.get()))
-	{
-		interactive->setGui(gui);
-		interactive->attach(widget);
-	}
-
 	if (_childWidgets.size() >= 1)
 	{
 		Unigine::WidgetVBoxPtr spacer = Unigine::WidgetVBox::create();
@@ -233,6 +646,55 @@ void noMoPi::WidgetContainer::addChild(const std::shared_ptr<WidgetBase>& widget
 		_widget->addChild(widget->getWidget());
 }
 
+bool WidgetContainer::reset()
+{
+	_layoutPosition = Unigine::Math::ivec2(0, 0);
+
+	while (!_childWidgets.empty())
+		removeChild(_childWidgets.back().get());
+
+	_padding = Unigine::Math::vec4_zero;
+	_paddingInPixels = Unigine::Math::ivec4_zero;
+	_isPaddingEqual = false;
+	_spacing = 0.f;
+	_ignorePadding = false;
+	_childIndex.clear();
+
+	if (Unigine::WidgetVBoxPtr vbox = Unigine::dynamic_ptr_cast<Unigine::WidgetVBox>(_widget))
+	{
+		vbox->setPadding(0, 0, 0, 0);
+		vbox->setBackground(false);
+		vbox->setBackgroundColor(Unigine::Math::vec4_one);
+		vbox->setBackgroundCustomFilterEnabled(false);
+		setBackgroundTexture(Settings::get().getWhiteBackgroundId());
+	}
+
+	return true;
+}
+
+bool WidgetContainer::removeChild(const WidgetBase* widget)
+{
+	auto it = std::find_if(_childWidgets.begin(), _childWidgets.end(), [widget](const std::shared_ptr<WidgetBase>& child) { return child.get() == widget; });
+	if (it == _childWidgets.end())
+		return false;
+
+	const size_t index = it - _childWidgets.begin();
+
+	if (!_spacers.empty())
+	{
+		const size_t spacerIndex = index > 0 ? index - 1 : 0;
+		_widget->removeChild(_spacers[spacerIndex]);
+		_spacers.erase(_spacers.begin() + spacerIndex);
+	}
+
+	if (Unigine::WidgetPtr engineWidget = (*it)->getWidget())
+		_widget->removeChild(engineWidget);
+
+	_childWidgets.erase(it);
+
+	return true;
+}
+
 WidgetContainer* WidgetContainer::setBackgroundEnabled(bool hasBackground)
 {
 	if (Unigine::WidgetVBoxPtr box = Unigine::dynamic_ptr_cast<Unigine::WidgetVBox>(_widget))
@@ -262,50 +724,190 @@ WidgetContainer* WidgetContainer::setBackgroundColor(int32_t r, int32_t g, int32
 	return setBackgroundColor(static_cast<float>(r) / 255, static_cast<float>(g) / 255, static_cast<float>(b) / 255, static_cast<float>(a) / 255);
 }
 
-WidgetContainer* noMoPi::WidgetContainer::setBackgroundTexture(const Unigine::String& texture)
+WidgetContainer* noMoPi::WidgetContainer::setBackgroundTexture(const char* texture)
 {
-	if (Unigine::WidgetVBoxPtr vbox = Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget))
+	return setBackgroundTexture(Settings::get().getTextureId(texture));
+}
+
+WidgetContainer* noMoPi::WidgetContainer::setBackgroundTexture(ResourceId texture)
+{
+	Unigine::WidgetVBoxPtr vbox = Unigine::dynamic_ptr_cast<Unigine::WidgetVBox>(_widget);
+	if (!vbox)
+		return this;
+
+	if (_isNineSliced)
 	{
-		vbox->setBackgroundTexture(Settings::get().getTexturesPath(texture));
+		vbox->setBackground9Sliced(false);
+		_isNineSliced = false;
 	}
-	
+
+	if (texture == _backgroundTexture)
+		return this;
+
+	vbox->setBackgroundRender(TextureCache::get().acquire(texture));
+
+	if (_backgroundTexture != InvalidResource)
+		TextureCache::get().release(_backgroundTexture);
+
+	_backgroundTexture = texture;
+
 	return this;
 }
 
-WidgetContainer* noMoPi::WidgetContainer::setBackgroundTextureFiltering(int32_t filtering)
+WidgetContainer* WidgetContainer::setBackgroundNineSlice(const char* texture, int32_t left, int32_t right, int32_t top, int32_t bottom)
 {
-	if (Unigine::WidgetVBoxPtr vbox = Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget))
+	return setBackgroundNineSlice(Settings::get().getTextureId(texture), left, right, top, bottom);
+}
+
+WidgetContainer* WidgetContainer::setBackgroundNineSlice(ResourceId texture, int32_t left, int32_t right, int32_t top, int32_t bottom)
+{
+	Unigine::WidgetVBoxPtr vbox = Unigine::dynamic_ptr_cast<Unigine::WidgetVBox>(_widget);
+	if (!vbox)
+		return this;
+
+	// only the header is read, the texture itself may still be loading asynchronously
+	Unigine::ImagePtr info = Unigine::Image::create();
+	if (!info->info(Settings::get().getPath(texture)) || info->getWidth() <= 0 || info->getHeight() <= 0)
 	{
-		vbox->setBackgroundCustomFilterEnabled(true);
-		vbox->setBackgroundCustomFilter(filtering);
+		Unigine::Log::error("noMoPi: can't read nine-slice texture \"%s\"\n", Settings::get().getPath(texture).get());
+		return this;
 	}
-	
+
+	setBackgroundTexture(texture);
+
+	const float width = static_cast<float>(info->getWidth());
+	const float height = static_cast<float>(info->getHeight());
+
+	vbox->setBackground9Sliced(true);
+	vbox->setBackground9SliceOffsets(left / width, right / width, top / height, bottom / height);
+	_isNineSliced = true;
+
+	_updateNineSlice();
+
 	return this;
 }
 
-VBox::VBox(const ScaleSettings& scaleSettings) : WidgetContainer(scaleSettings)
+void WidgetContainer::_updateNineSlice()
 {
-	_widget = Unigine::WidgetVBox::create();
+	if (!_isNineSliced)
+		return;
 
-	if (Unigine::WidgetVBoxPtr vbox = Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget))
-	{
-		vbox->setBackgroundTexture(Settings::get().getWhiteBackground());
-		vbox->setStencil(true);
-	}
-		
+	Unigine::GuiPtr gui = _widget->getGui();
+	if (!gui)
+		return;
+
+	Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget)->setBackground9SliceScale(Settings::get().getScale(gui->getHeight()));
 }
 
-Label::Label(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+void WidgetContainer::collectTextures(std::vector<ResourceId>& textures) const
 {
-	_widget = Unigine::WidgetHBox::create();
-	_label = Unigine::WidgetLabel::create();
-	_widget->addChild(_label);
+	if (_backgroundTexture != InvalidResource)
+		textures.push_back(_backgroundTexture);
+
+	for (auto& child : _childWidgets)
+		child->collectTextures(textures);
 }
 
-Label* Label::setText(const char* text, bool isTranslatable)
+void WidgetContainer::collectFootprint(Footprint& footprint) const
 {
-	if (isTranslatable)
-	{
+	WidgetBase::collectFootprint(footprint);
+
+	footprint.engineWidgetCount += static_cast<uint32_t>(_spacers.size());
+	footprint.bytes += sizeof(WidgetContainer) - sizeof(WidgetBase);
+	footprint.bytes += _childWidgets.capacity() * sizeof(std::shared_ptr<WidgetBase>) + _spacers.capacity() * sizeof(Unigine::WidgetVBoxPtr);
+	footprint.bytes += _childIndex.getBytes() + _childRects.capacity() * sizeof(Unigine::Math::ivec4) + _pickCandidates.capacity() * sizeof(int32_t) + _rayCandidates.capacity() * sizeof(SpatialIndex::RayHit);
+
+	if (_backgroundTexture != InvalidResource)
+		footprint.textureCount++;
+}
+
+void WidgetContainer::collectGlyphs(GlyphWarmup& warmup) const
+{
+	for (auto& child : _childWidgets)
+		child->collectGlyphs(warmup);
+}
+
+WidgetContainer::~WidgetContainer()
+{
+	if (_backgroundTexture != InvalidResource)
+		TextureCache::get().release(_backgroundTexture);
+}
+
+WidgetContainer* noMoPi::WidgetContainer::setBackgroundTextureFiltering(int32_t filtering)
+{
+	if (Unigine::WidgetVBoxPtr vbox = Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget))
+	{
+		vbox->setBackgroundCustomFilterEnabled(true);
+		vbox->setBackgroundCustomFilter(filtering);
+	}
+	
+	return this;
+}
+
+VBox::VBox(const ScaleSettings& scaleSettings) : WidgetContainer(scaleSettings)
+{
+	_widget = Unigine::WidgetVBox::create();
+
+	if (Unigine::WidgetVBoxPtr vbox = Unigine::static_ptr_cast<Unigine::WidgetVBox>(_widget))
+		vbox->setStencil(true);
+
+	setBackgroundTexture(Settings::get().getWhiteBackgroundId());
+}
+
+Label::Label(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+{
+	_widget = Unigine::WidgetHBox::create();
+	_label = Unigine::WidgetLabel::create();
+	_widget->addChild(_label);
+}
+
+bool Label::reset()
+{
+	_layoutPosition = Unigine::Math::ivec2(0, 0);
+
+	// the engine has no way back to the default font, so a label with a custom one gets a fresh engine label
+	if (_font != InvalidResource)
+	{
+		_widget->removeChild(_label);
+		_label = Unigine::WidgetLabel::create();
+		_widget->addChild(_label);
+	}
+	else
+	{
+		_label->setText("");
+		_label->setTextAlign(Unigine::Gui::ALIGN_LEFT);
+		_label->setFlags(0);
+		_label->setFontWrap(0);
+		_label->setFontHSpacing(0);
+		_label->setFontVSpacing(0);
+	}
+
+	_font = InvalidResource;
+	_fontSizeUsage.set(InvalidResource, 0);
+
+	_isTextTranslatable = false;
+	_targetText.clear();
+	_keyText.clear();
+
+	_maxFontSize = 0;
+	_fontSize = 1.f;
+	_newLineCount = 0;
+	_fontWrap = false;
+
+	_fontMaxHSpacing = 0.f;
+	_maxfontHSpacing = 0;
+	_fontMaxVSpacing = 0.f;
+	_maxfontVSpacing = 0;
+	_fontHSpacing = 0.f;
+	_fontVSpacing = 0.f;
+
+	return true;
+}
+
+Label* Label::setText(const char* text, bool isTranslatable)
+{
+	if (isTranslatable)
+	{
 		Unigine::GuiPtr gui = _widget->getGui();
 		_keyText = text;
 		_targetText = gui->translate(text);
@@ -334,7 +936,7 @@ Label* Label::setFontSize(float fontSize)
 {
 	_fontSize = std::clamp(fontSize, 0.f, 1.f);
 
-	_label->setFontSize(static_cast<int32_t>(_maxFontSize * fontSize));
+	_applyFontSize(static_cast<int32_t>(_maxFontSize * _fontSize));
 	
 	return this;
 }
@@ -401,7 +1003,14 @@ Label* Label::setTextAlign(Align horizontal, Align vertical)
 
 Label* noMoPi::Label::setDefaultFont(int32_t fontIndex)
 {
-	_label->setFont(Settings::get().getDefaultFont(fontIndex));
+	return setFont(Settings::get().getDefaultFontId(fontIndex));
+}
+
+Label* noMoPi::Label::setFont(ResourceId font)
+{
+	_font = font;
+	_label->setFont(Settings::get().getPath(font));
+	_fontSizeUsage.set(_font, _label->getFontSize());
 
 	_calculateMaxFontParams();
 
@@ -458,257 +1067,4484 @@ void noMoPi::Label::_updateFont(int32_t width)
 		_label->setWidth(width);
 
 		if (!_fontWrap)
-			_label->setFontSize(static_cast<int32_t>(_maxFontSize * _fontSize));
+			_applyFontSize(static_cast<int32_t>(_maxFontSize * _fontSize));
 		else
-			_label->setFontSize(_maxFontSize);
+			_applyFontSize(_maxFontSize);
 
 		_label->setFontHSpacing(static_cast<int32_t>(_maxfontHSpacing * _fontHSpacing));
 		_label->setFontVSpacing(static_cast<int32_t>(_maxfontVSpacing * _fontVSpacing));
 	}
 }
 
+void noMoPi::Label::_applyFontSize(int32_t fontSize)
+{
+	fontSize = FontSizePolicy::get().quantize(fontSize);
+
+	_label->setFontSize(fontSize);
+	_fontSizeUsage.set(_font, fontSize);
+}
+
 void noMoPi::Label::_calculateMaxFontParams()
 {
-	const int32_t height = _widget->getHeight();
-	const int32_t width = _widget->getWidth();
+	NOMOPI_PROFILER_SCOPED("noMoPi::Label::_calculateMaxFontParams");
+
+	const FontParams params = _calculateFontParams(_label, _widget->getWidth(), _widget->getHeight());
+
+	_maxFontSize = params.maxFontSize;
+	_maxfontHSpacing = params.maxFontHSpacing;
+	_maxfontVSpacing = params.maxFontVSpacing;
+}
+
+Label::FontParams noMoPi::Label::_calculateFontParams(const Unigine::WidgetLabelPtr& label, int32_t width, int32_t height) const
+{
+	FontParams params;
 
 	if (!_fontWrap)
 	{
-		_label->setFontSize(height);
-		const Unigine::Math::ivec2 textRawRenderSize = _label->getTextRenderSize(_targetText);
+		const int32_t measureSize = FontSizePolicy::get().quantize(height);
+		const float measureScale = measureSize > 0 ? static_cast<float>(height) / measureSize : 1.f;
+
+		label->setFontSize(measureSize);
+		const Unigine::Math::ivec2 textRawRenderSize = LayoutTrace::measureText(label, _targetText);
 		
-		_label->setFontHSpacing(static_cast<int32_t>(height * _fontMaxHSpacing));
-		_label->setFontVSpacing(static_cast<int32_t>(height * _fontMaxVSpacing));
+		label->setFontHSpacing(static_cast<int32_t>(measureSize * _fontMaxHSpacing));
+		label->setFontVSpacing(static_cast<int32_t>(measureSize * _fontMaxVSpacing));
 
-		const Unigine::Math::ivec2 textRenderSizeWithSpacing = _label->getTextRenderSize(_targetText);
+		const Unigine::Math::ivec2 textRenderSizeWithSpacing = LayoutTrace::measureText(label, _targetText);
+		FrameCounters::getCurrent().textMeasurements += 2;
 
 		const float hScaleProportion = static_cast<float>(textRenderSizeWithSpacing.x) / textRawRenderSize.x;
 		const float vScaleProportion = 1.f + _fontMaxVSpacing;
 
-		_maxFontSize = height / (_newLineCount + 1);
-		if (textRenderSizeWithSpacing.x > width)
+		params.maxFontSize = height / (_newLineCount + 1);
+		if (textRenderSizeWithSpacing.x * measureScale > width)
 		{
 			float maxBaseWidth = static_cast<float>(width) / hScaleProportion;
 
-			_maxFontSize = static_cast<int32_t>(height * (maxBaseWidth / textRawRenderSize.x));
+			params.maxFontSize = static_cast<int32_t>(height * (maxBaseWidth / (textRawRenderSize.x * measureScale)));
 		}
-		if (textRenderSizeWithSpacing.y > height)
+		if (textRenderSizeWithSpacing.y * measureScale > height)
 		{
 			float maxBaseHeight = static_cast<float>(height) / vScaleProportion;
 
-			_maxFontSize = std::min(static_cast<int32_t>(height * (maxBaseHeight / textRawRenderSize.y)), _maxFontSize);
+			params.maxFontSize = std::min(static_cast<int32_t>(height * (maxBaseHeight / (textRawRenderSize.y * measureScale))), params.maxFontSize);
 		}
 	}
 	else
-		_maxFontSize = static_cast<int32_t>(height * _fontSize);
+		params.maxFontSize = static_cast<int32_t>(height * _fontSize);
 
-	_maxfontHSpacing = static_cast<int32_t>(_maxFontSize * _fontMaxHSpacing);
-	_maxfontVSpacing = static_cast<int32_t>(_maxFontSize * _fontMaxVSpacing);
+	params.maxFontHSpacing = static_cast<int32_t>(params.maxFontSize * _fontMaxHSpacing);
+	params.maxFontVSpacing = static_cast<int32_t>(params.maxFontSize * _fontMaxVSpacing);
+
+	return params;
 }
 
-Unigine::String noMoPi::Settings::getLocalizationPath(const Unigine::String& file) const
+void Label::planLayout(LayoutJob& job, LayoutRecord& record)
 {
-	return _rootFolder + _localizationFolder + file;
+	const FontParams params = _calculateFontParams(job.getMeasureLabel(_font), record.width, record.height);
+
+	record.maxFontSize = params.maxFontSize;
+	record.maxFontHSpacing = params.maxFontHSpacing;
+	record.maxFontVSpacing = params.maxFontVSpacing;
 }
 
-Unigine::String noMoPi::Settings::getFontsPath(const Unigine::String& font) const
+void Label::commitLayout(const LayoutRecord& record)
 {
-	return _rootFolder + _localizationFolder + font;
+	WidgetBase::resize(record.width, record.height);
+
+	_maxFontSize = record.maxFontSize;
+	_maxfontHSpacing = record.maxFontHSpacing;
+	_maxfontVSpacing = record.maxFontVSpacing;
+
+	_updateFont(record.width);
 }
 
-Unigine::String noMoPi::Settings::getTexturesPath(const Unigine::String& texture) const
+Settings::Settings()
 {
-	return _rootFolder + _texturesFolder + texture;
+	_whiteBackgroundId = getTextureId(_whiteBackground);
 }
 
-Unigine::String Settings::getWhiteBackground() const
+ResourceId Settings::getTextureId(const char* texture)
 {
-	return _rootFolder + _texturesFolder + _whiteBackground;
+	return _intern(_textureIds, _texturesFolder, texture);
 }
 
-int32_t Settings::addDefaultFont(const char* font)
+ResourceId Settings::getFontId(const char* font)
 {
-	int32_t fontIndex = _defaultFonts.size();
+	return _intern(_fontIds, _fontsFolder, font);
+}
 
-	_defaultFonts.push_back(font);
+ResourceId Settings::getLocalizationId(const char* file)
+{
+	return _intern(_localizationIds, _localizationFolder, file);
+}
 
-	return fontIndex;
+ResourceId Settings::getLayoutId(const char* file)
+{
+	return _intern(_layoutIds, _layoutsFolder, file);
 }
 
-Unigine::String noMoPi::Settings::getDefaultFont(int32_t fontIndex)
+ResourceId Settings::getResourceId(const char* path)
 {
-	return _rootFolder + _fontsFolder + _defaultFonts[fontIndex];
+	auto it = _pathIds.find(path);
+	if (it != _pathIds.end())
+		return it->data;
+
+	ResourceId id = static_cast<ResourceId>(_paths.size());
+	_paths.emplace_back(path);
+	_pathIds.append(Unigine::String(path), id);
+
+	return id;
 }
 
-void UI::translate()
+ResourceId Settings::_intern(Unigine::HashMap<Unigine::String, ResourceId>& ids, const Unigine::String& folder, const char* name)
 {
-	_rootWidget->translate();
+	auto it = ids.find(name);
+	if (it != ids.end())
+		return it->data;
+
+	ResourceId id = getResourceId(_rootFolder + folder + name);
+	ids.append(Unigine::String(name), id);
+
+	return id;
 }
 
-void noMoPi::UI::tick()
+int32_t Settings::addDefaultFont(const char* font)
 {
-	_rootWidget->tick(Unigine::Engine::get()->getIFps());
+	int32_t fontIndex = static_cast<int32_t>(_defaultFonts.size());
+
+	_defaultFonts.push_back(getFontId(font));
+
+	return fontIndex;
 }
 
-void UI::addChild(const std::shared_ptr<WidgetBase>& widget)
+Unigine::TexturePtr TextureCache::acquire(ResourceId texture)
 {
-	_rootWidget->addChild(widget);
+	auto it = _textures.find(texture);
+	if (it != _textures.end())
+	{
+		if (it->data.preloadTime)
+		{
+			it->data.preloadTime = 0;
+			_preloadedCount--;
+			_statistics.preloadHits++;
+		}
+		else
+			_statistics.hits++;
+
+		it->data.references++;
+		return it->data.texture;
+	}
+
+	_statistics.misses++;
+
+	Entry& entry = _createEntry(texture, _isAsyncLoading);
+	entry.references = 1;
+
+	return entry.texture;
 }
 
-void WidgetContainer::translate()
+TextureCache::Entry& TextureCache::_createEntry(ResourceId texture, bool isAsync)
 {
-	for (auto& child : _childWidgets)
-		child->translate();
+	const Unigine::String& path = Settings::get().getPath(texture);
+
+	Entry entry;
+	entry.texture = Unigine::Texture::create();
+
+	if (isAsync)
+	{
+		entry.texture->create(_getPlaceholder());
+		entry.asyncId = Unigine::AsyncQueue::loadImage(path);
+		_statistics.pendingCount++;
+	}
+	else
+	{
+		if (!entry.texture->load(path))
+			Unigine::Log::error("noMoPi: can't load texture \"%s\"\n", path.get());
+
+		entry.bytes = entry.texture->getVideoMemoryUsage();
+		_statistics.bytes += entry.bytes;
+	}
+
+	_statistics.textureCount++;
+
+	_textures.append(texture, entry);
+
+	return _textures[texture];
 }
 
-void WidgetContainer::tick(float deltaTime)
+const Unigine::ImagePtr& TextureCache::_getPlaceholder()
 {
-	for (auto& child : _childWidgets)
-		child->tick(deltaTime);
+	if (!_placeholder)
+	{
+		_placeholder = Unigine::Image::create();
+		_placeholder->create2D(1, 1, Unigine::Image::FORMAT_RGBA8);
+		_placeholder->set2D(0, 0, Unigine::Image::Pixel(255, 255, 255, 255));
+	}
+
+	return _placeholder;
 }
 
-void Label::translate()
+void TextureCache::preload(const std::vector<ResourceId>& textures)
 {
-	Unigine::GuiPtr gui = _widget->getGui();
+	for (ResourceId texture : textures)
+		_preload(texture);
+}
 
-	setText(gui->translate(_keyText));
+void TextureCache::preload(const std::vector<Unigine::String>& paths)
+{
+	for (const auto& path : paths)
+		_preload(Settings::get().getResourceId(path));
+}
+
+void TextureCache::_preload(ResourceId texture)
+{
+	if (_textures.contains(texture))
+		return;
 
+	_createEntry(texture, true).preloadTime = Unigine::Time::get();
+	_preloadedCount++;
+}
 
-	_calculateMaxFontParams();
+std::vector<ResourceId> TextureCache::collectTextures(const std::shared_ptr<WidgetBase>& widget)
+{
+	std::vector<ResourceId> textures;
+	widget->collectTextures(textures);
 
-	_updateFont(_widget->getWidth());
+	std::sort(textures.begin(), textures.end());
+	textures.erase(std::unique(textures.begin(), textures.end()), textures.end());
+	return textures;
 }
 
-ScrollBox::ScrollBox(const ScaleSettings& scaleSettings) : WidgetContainer(scaleSettings)
+void TextureCache::update()
 {
-	Unigine::WidgetScrollBoxPtr scroll = Unigine::WidgetScrollBox::create();
+	if (_preloadedCount)
+	{
+		const long long oldest = Unigine::Time::get() - static_cast<long long>(_maxPreloadTime * static_cast<double>(Unigine::Time::CLOCKS_PER_SECOND));
 
-	scroll->setVScrollEnabled(true);
-	scroll->setHScrollEnabled(false);
-	Unigine::WidgetScrollPtr scr = scroll->getVScroll();
-	scr->setSliderButton(false);
-	scroll->setBorder(0);
-	/*static Unigine::EventConnection ec;
-	scroll->getEventChanged().connect(ec, [](const Unigine::WidgetPtr& widget) {
-		Unigine::WidgetScrollBoxPtr scr = Unigine::dynamic_ptr_cast<Unigine::WidgetScrollBox>(widget);
-		Unigine::WidgetScrollPtr scroll = scr->getVScroll();
-		Unigine::Log::message("%d %d\n", scr->getVScrollValue() / scr->getScrollScale(), (scr->getVScrollObjectSize() - scr->getVScrollFrameSize()) / scr->getScrollScale());
-		});
-	for (int i = 0; i < 100; i++)
+		for (auto it = _textures.begin(); it != _textures.end();)
+		{
+			if (it->data.preloadTime && it->data.preloadTime < oldest)
+			{
+				_preloadedCount--;
+				_statistics.expiredCount++;
+				it = _erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	if (!_statistics.pendingCount)
+		return;
+
+	for (auto& texture : _textures)
 	{
-		scroll->addChild(Unigine::WidgetButton::create("test"));
-	}*/
-	
-	_widget = scroll;
+		Entry& entry = texture.data;
+		if (entry.asyncId < 0 || !Unigine::AsyncQueue::checkImage(entry.asyncId))
+			continue;
+
+		Unigine::ImagePtr image = Unigine::AsyncQueue::takeImage(entry.asyncId);
+		if (image)
+			entry.texture->create(image);
+		else
+			Unigine::Log::error("noMoPi: can't load texture \"%s\"\n", Settings::get().getPath(texture.key).get());
+
+		entry.asyncId = -1;
+		entry.bytes = entry.texture->getVideoMemoryUsage();
+
+		_statistics.bytes += entry.bytes;
+		_statistics.pendingCount--;
+	}
 }
 
-void ScrollBox::resize(int32_t width, int32_t height)
+void TextureCache::release(ResourceId texture)
 {
-	WidgetContainer::resize(width - 16, height);
+	auto it = _textures.find(texture);
+	if (it == _textures.end())
+		return;
 
-	Unigine::WidgetScrollBoxPtr scr = Unigine::dynamic_ptr_cast<Unigine::WidgetScrollBox>(_widget);
+	if (--it->data.references > 0)
+		return;
 
-	//_widget->setWidth(width - 16);
+	_erase(it);
 }
 
-ScrollBox* noMoPi::ScrollBox::setVisibleItemCount(int32_t itemCount)
+void TextureCache::clear()
 {
-	_itemCount = itemCount;
-	
-	return this;
+	for (auto it = _textures.begin(); it != _textures.end();)
+		it = _erase(it);
+
+	_preloadedCount = 0;
+	_placeholder = nullptr;
 }
 
-void ScrollBox::_resizeChildren()
+Unigine::HashMap<ResourceId, TextureCache::Entry>::Iterator TextureCache::_erase(Unigine::HashMap<ResourceId, Entry>::Iterator it)
 {
-	int32_t height = getHeight();
-	int32_t scaledSpacing = static_cast<int32_t>(height * _spacing);
-	height -= (_childWidgets.size() - 2) * scaledSpacing;
-	
-	for (auto& child : _childWidgets)
+	if (it->data.asyncId >= 0)
 	{
-		child->resize(getWidth(), height / _itemCount);
+		Unigine::AsyncQueue::removeImage(it->data.asyncId);
+		_statistics.pendingCount--;
 	}
+
+	_statistics.bytes -= it->data.bytes;
+	_statistics.textureCount--;
+
+	return _textures.erase(it);
 }
 
-EditLine::EditLine(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+void TextureCache::resetStatistics()
 {
-	Unigine::WidgetEditLinePtr _editLine = Unigine::WidgetEditLine::create("test");
-	_editLine->setStyleTextureBackground(".noMorePixels/textures/white.png");
-	_editLine->setBackgroundColor(Unigine::Math::vec4_green);
-	_editLine->setBorderColor(Unigine::Math::vec4_zero);
+	_statistics.hits = 0;
+	_statistics.misses = 0;
+	_statistics.preloadHits = 0;
+	_statistics.expiredCount = 0;
+}
 
-	_widget = _editLine;
+size_t TextureCache::getBytes(ResourceId texture) const
+{
+	auto it = _textures.find(texture);
+
+	return it != _textures.end() ? it->data.bytes : 0;
 }
 
-void EditLine::resize(int32_t width, int32_t height)
+// Repeats the region's edge pixels into its padding, so filtering never picks up a neighbour
+static void extrudeEdges(const Unigine::ImagePtr& atlas, const Unigine::ImagePtr& image, const Unigine::Math::ivec4& rect, int32_t padding)
 {
-	// no way to remove the border, so this is a temporary fix
-	_widget->setWidth(width - 4);
-	_widget->setHeight(height - 4);
+	for (int32_t i = 1; i <= padding; i++)
+	{
+		atlas->copy(image, rect.x - i, rect.y, 0, 0, 1, rect.w);
+		atlas->copy(image, rect.x + rect.z - 1 + i, rect.y, rect.z - 1, 0, 1, rect.w);
+		atlas->copy(image, rect.x, rect.y - i, 0, 0, rect.z, 1);
+		atlas->copy(image, rect.x, rect.y + rect.w - 1 + i, 0, rect.w - 1, rect.z, 1);
+	}
 
-	_calculateMaxFontSize();
+	const Unigine::Math::ivec2 corners[] = { { 0, 0 }, { rect.z - 1, 0 }, { 0, rect.w - 1 }, { rect.z - 1, rect.w - 1 } };
+	for (const Unigine::Math::ivec2& corner : corners)
+	{
+		const Unigine::Image::Pixel pixel = image->get2D(corner.x, corner.y);
+		const int32_t x0 = corner.x == 0 ? rect.x - padding : rect.x + rect.z;
+		const int32_t y0 = corner.y == 0 ? rect.y - padding : rect.y + rect.w;
 
-	_widget->setFontSize(_maxFontSize);
+		for (int32_t y = y0; y < y0 + padding; y++)
+		{
+			for (int32_t x = x0; x < x0 + padding; x++)
+				atlas->set2D(x, y, pixel);
+		}
+	}
 }
 
-void noMoPi::EditLine::_calculateMaxFontSize()
+static bool isSamePixel(const Unigine::Image::Pixel& a, const Unigine::Image::Pixel& b)
 {
-	int32_t height = _widget->getHeight();
-	
-	_maxFontSize = static_cast<int32_t>((height - 5) * _magicMaxFontProportion + 2);
+	return a.i.r == b.i.r && a.i.g == b.i.g && a.i.b == b.i.b && a.i.a == b.i.a;
 }
 
-EditLine* EditLine::setDefaultFont(int32_t fontIndex)
+bool TextureAtlas::build(const std::vector<Unigine::String>& textures, int32_t maxSize, int32_t padding)
 {
-	_widget->setFont(Settings::get().getDefaultFont(fontIndex));
+	std::vector<Unigine::ImagePtr> images;
 
-	return this;
+	for (const auto& texture : textures)
+	{
+		Unigine::ImagePtr image = Unigine::Image::create();
+		if (!image->load(Settings::get().getTexturesPath(texture)))
+		{
+			Unigine::Log::error("noMoPi: can't load atlas texture \"%s\"\n", texture.get());
+			clear();
+			return false;
+		}
+
+		if (image->isCompressedFormat())
+			image->decompress();
+		image->convertToFormat(Unigine::Image::FORMAT_RGBA8);
+
+		images.push_back(image);
+	}
+
+	return build(textures, images, maxSize, padding);
 }
 
-noMoPi::CheckBox::CheckBox(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+bool TextureAtlas::build(const std::vector<Unigine::String>& textures, const std::vector<Unigine::ImagePtr>& images, int32_t maxSize, int32_t padding)
 {
-	Unigine::WidgetSpritePtr sprite = Unigine::WidgetSprite::create();
+	clear();
+
+	if (textures.size() != images.size())
+	{
+		Unigine::Log::error("noMoPi: %zu atlas textures named for %zu images\n", textures.size(), images.size());
+		return false;
+	}
+
+	std::vector<Unigine::Math::ivec2> sizes;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const Unigine::Math::ivec2 size(images[i]->getWidth(), images[i]->getHeight());
+		if (size.x <= 0 || size.y <= 0)
+		{
+			Unigine::Log::error("noMoPi: atlas texture \"%s\" is empty\n", textures[i].get());
+			return false;
+		}
+
+		sizes.push_back(size);
+	}
 
-	_backgroundTexture = Unigine::Texture::create();
-	_backgroundTexture->load(Settings::get().getTexturesPath("border.png"));
-	//_backgroundTexture->setSamplerFlags(Unigine::Texture::SAMPLER_FILTER_POINT);
+	std::vector<Unigine::Math::ivec4> rects;
+	if (!pack(sizes, maxSize, padding, rects, _size))
+	{
+		Unigine::Log::error("noMoPi: textures don't fit into a %dx%d atlas\n", maxSize, maxSize);
+		return false;
+	}
 
-	sprite->setRender(_backgroundTexture);
+	_image = Unigine::Image::create();
+	_image->create2D(_size.x, _size.y, Unigine::Image::FORMAT_RGBA8);
 
-	_tickTexture = Unigine::Texture::create();
-	_tickTexture->load(Settings::get().getTexturesPath("tick.png"));
-	//_tickTexture->setSamplerFlags(Unigine::Texture::SAMPLER_FILTER_POINT);
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const Unigine::ImagePtr& image = images[i];
+		const Unigine::Math::ivec4& rect = rects[i];
 
-	sprite->setLayerRender(sprite->addLayer(), _tickTexture);
+		_image->copy(image, rect.x, rect.y, 0, 0, rect.z, rect.w);
+		extrudeEdges(_image, image, rect, padding);
 
-	static Unigine::EventConnection ec;
+		Region region;
+		region.rect = rect;
+		region.texCoord = Unigine::Math::vec4(
+			static_cast<float>(rect.x) / _size.x,
+			static_cast<float>(rect.y) / _size.y,
+			static_cast<float>(rect.x + rect.z) / _size.x,
+			static_cast<float>(rect.y + rect.w) / _size.y);
 
-	sprite->getEventClicked().connect(ec, [](const Unigine::WidgetPtr& widget, int mouse) {
-		Unigine::WidgetSpritePtr sprite = Unigine::dynamic_ptr_cast<Unigine::WidgetSprite>(widget);
-		sprite->setLayerEnabled(1, !sprite->isLayerEnabled(1));
-		});
+		_regions.append(textures[i], region);
+	}
 
-	_widget = sprite;
+	_padding = padding;
+
+	_texture = Unigine::Texture::create();
+	_texture->create(_image);
+
+	return true;
 }
 
-void noMoPi::Interactive::setGui(Unigine::GuiPtr gui)
+void TextureAtlas::clear()
 {
-	_interactiveLayer->setGui(gui);
+	_regions.clear();
+	_image = nullptr;
+	_texture = nullptr;
+	_size = Unigine::Math::ivec2(0, 0);
 }
 
-Interactive::Interactive()
+bool TextureAtlas::validate() const
 {
-	_interactiveLayer = Unigine::WidgetButton::create("");
-	_interactiveLayer->setBackground(false);
+	std::vector<Unigine::Math::ivec4> rects;
+	for (const auto& region : _regions)
+	{
+		const Region& data = region.data;
+		rects.push_back(data.rect);
+
+		const Unigine::Math::vec4 expectedTexCoord(
+			static_cast<float>(data.rect.x) / _size.x,
+			static_cast<float>(data.rect.y) / _size.y,
+			static_cast<float>(data.rect.x + data.rect.z) / _size.x,
+			static_cast<float>(data.rect.y + data.rect.w) / _size.y);
+
+		if (data.texCoord != expectedTexCoord)
+		{
+			Unigine::Log::error("noMoPi: atlas region \"%s\" has wrong texture coordinates\n", region.key.get());
+			return false;
+		}
+
+		for (int32_t y = -_padding; y < data.rect.w + _padding; y++)
+		{
+			for (int32_t x = -_padding; x < data.rect.z + _padding; x++)
+			{
+				const int32_t nearestX = std::clamp(x, 0, data.rect.z - 1);
+				const int32_t nearestY = std::clamp(y, 0, data.rect.w - 1);
+				if (nearestX == x && nearestY == y)
+					continue;
+
+				if (!isSamePixel(_image->get2D(data.rect.x + x, data.rect.y + y), _image->get2D(data.rect.x + nearestX, data.rect.y + nearestY)))
+				{
+					Unigine::Log::error("noMoPi: atlas region \"%s\" isn't extruded into its padding at %d %d\n", region.key.get(), x, y);
+					return false;
+				}
+			}
+		}
+
+		Unigine::ImagePtr source = Unigine::Image::create();
+		if (!source->load(Settings::get().getTexturesPath(region.key)))
+			continue;
+
+		if (source->isCompressedFormat())
+			source->decompress();
+		source->convertToFormat(Unigine::Image::FORMAT_RGBA8);
+
+		if (source->getWidth() != data.rect.z || source->getHeight() != data.rect.w)
+		{
+			Unigine::Log::error("noMoPi: atlas region \"%s\" has wrong size\n", region.key.get());
+			return false;
+		}
+
+		for (int32_t y = 0; y < data.rect.w; y++)
+		{
+			for (int32_t x = 0; x < data.rect.z; x++)
+			{
+				const Unigine::Image::Pixel expected = source->get2D(x, y);
+				const Unigine::Image::Pixel packed = _image->get2D(data.rect.x + x, data.rect.y + y);
+
+				if (!isSamePixel(expected, packed))
+				{
+					Unigine::Log::error("noMoPi: atlas region \"%s\" differs from the source at %d %d\n", region.key.get(), x, y);
+					return false;
+				}
+			}
+		}
+	}
+
+	return validatePacking(rects, _size, _padding);
 }
 
-void Interactive::resize(int32_t width, int32_t height)
+bool TextureAtlas::pack(const std::vector<Unigine::Math::ivec2>& sizes, int32_t maxSize, int32_t padding,
+	std::vector<Unigine::Math::ivec4>& rects, Unigine::Math::ivec2& atlasSize)
 {
-	_interactiveLayer->setWidth(width);
-	_interactiveLayer->setHeight(height);
+	std::vector<int32_t> order(sizes.size());
+	for (int32_t i = 0; i < static_cast<int32_t>(order.size()); i++)
+		order[i] = i;
+
+	std::sort(order.begin(), order.end(), [&sizes](int32_t a, int32_t b) {
+		return sizes[a].y != sizes[b].y ? sizes[a].y > sizes[b].y : sizes[a].x > sizes[b].x;
+		});
+
+	rects.assign(sizes.size(), Unigine::Math::ivec4(0, 0, 0, 0));
+
+	for (int32_t width = 64; width <= maxSize; width *= 2)
+	{
+		int32_t x = 0;
+		int32_t y = 0;
+		int32_t shelfHeight = 0;
+		bool isFitting = true;
+
+		for (int32_t index : order)
+		{
+			const int32_t cellWidth = sizes[index].x + padding * 2;
+			const int32_t cellHeight = sizes[index].y + padding * 2;
+
+			if (cellWidth > width)
+			{
+				isFitting = false;
+				break;
+			}
+
+			if (x + cellWidth > width)
+			{
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+
+			rects[index] = Unigine::Math::ivec4(x + padding, y + padding, sizes[index].x, sizes[index].y);
+
+			x += cellWidth;
+			shelfHeight = std::max(shelfHeight, cellHeight);
+		}
+
+		const int32_t height = y + shelfHeight;
+		if (!isFitting || height > width)
+			continue;
+
+		atlasSize = Unigine::Math::ivec2(width, 1);
+		while (atlasSize.y < height)
+			atlasSize.y *= 2;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool TextureAtlas::validatePacking(const std::vector<Unigine::Math::ivec4>& rects, const Unigine::Math::ivec2& atlasSize, int32_t padding)
+{
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		const Unigine::Math::ivec4& a = rects[i];
+		if (a.x < padding || a.y < padding || a.x + a.z + padding > atlasSize.x || a.y + a.w + padding > atlasSize.y)
+			return false;
+
+		for (size_t j = i + 1; j < rects.size(); j++)
+		{
+			const Unigine::Math::ivec4& b = rects[j];
+
+			const bool isSeparated =
+				a.x + a.z + padding <= b.x - padding || b.x + b.z + padding <= a.x - padding ||
+				a.y + a.w + padding <= b.y - padding || b.y + b.w + padding <= a.y - padding;
+
+			if (!isSeparated)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void UI::translate()
+{
+	NOMOPI_PROFILER_SCOPED(_profilerName.get());
+	NOMOPI_PROFILER_SCOPED("noMoPi::UI::translate");
+	AllocationScope allocationScope(AllocationTracker::Operation::Translate);
+
+	if (!_rootWidget)
+		return;
+
+	const long long begin = Unigine::Time::get();
+
+	{
+		FrameBudgetScope budgetScope(*_rootWidget, _frameBudgetMicroseconds > 0);
+		_rootWidget->translate();
+	}
+
+	_checkFrameBudget("translate", Unigine::Time::get() - begin);
+}
+
+void noMoPi::UI::tick()
+{
+	tick(Unigine::Engine::get()->getIFps());
+}
+
+void noMoPi::UI::tick(float deltaTime)
+{
+	NOMOPI_PROFILER_SCOPED(_profilerName.get());
+	NOMOPI_PROFILER_SCOPED("noMoPi::UI::tick");
+	AllocationScope allocationScope(AllocationTracker::Operation::Tick);
+
+	const long long begin = Unigine::Time::get();
+	_isTicking = true;
+
+	TextureCache::get().update();
+	WidgetRecycler::get().update();
+	_widgets.update();
+
+	_updateInput();
+	_dispatchEvents();
+
+	if (_rootWidget)
+	{
+		if (_isLayoutSpreading && _frameBudgetMicroseconds > 0 && isLayoutPending())
+			_spreadLayout(begin);
+		else if (_isLayoutRequested)
+			updateLayout();
+
+		FrameBudgetScope budgetScope(*_rootWidget, _frameBudgetMicroseconds > 0);
+		_rootWidget->tick(deltaTime);
+	}
+
+	_isTicking = false;
+	_checkFrameBudget("tick", Unigine::Time::get() - begin);
+	_frameMicroseconds = 0;
+	_isOverBudget = false;
+
+	FrameCounters& counters = FrameCounters::getCurrent();
+	_frameStatistics.counters = counters;
+	counters = FrameCounters();
+
+	_frameStatistics.layoutMilliseconds = Unigine::Time::microsecondsToMilliseconds(_layoutMicroseconds);
+	_frameStatistics.tickMilliseconds = Unigine::Time::microsecondsToMilliseconds(Unigine::Time::get() - begin);
+	_frameStatistics.allocationCount = Unigine::Memory::isStatisticsEnabled() ? Unigine::Memory::getFrameAllocations() : -1;
+	_layoutMicroseconds = 0;
+
+#ifdef NOMOPI_PROFILER
+	Unigine::Profiler::setValue("noMoPi widgets laid out", "", _frameStatistics.counters.widgetsLaidOut, 0, nullptr);
+	Unigine::Profiler::setValue("noMoPi text measurements", "", _frameStatistics.counters.textMeasurements, 0, nullptr);
+#endif
+
+	if (_overlay)
+	{
+		_overlay->update(*this, deltaTime);
+		counters = FrameCounters();
+	}
+}
+
+void UI::setOverlay(const std::shared_ptr<PerformanceOverlay>& overlay)
+{
+	if (_overlay)
+		_gui->removeChild(*_overlay->getRoot());
+
+	_overlay = overlay;
+	if (!_overlay)
+		return;
+
+	_overlay->getRoot()->setGui(_gui);
+	_gui->addChild(*_overlay->getRoot(), Unigine::Gui::ALIGN_OVERLAP);
+
+	Unigine::Math::ivec2 guiSize = _gui->getSize();
+	_overlay->resize(guiSize.x, guiSize.y);
+}
+
+void UI::startTrace()
+{
+	_trace = std::make_unique<LayoutTrace>();
+}
+
+bool UI::stopTrace(const char* path)
+{
+	if (!_trace)
+		return false;
+
+	std::unique_ptr<LayoutTrace> trace = std::move(_trace);
+	if (trace->passes.empty())
+	{
+		Unigine::Log::error("noMoPi: layout trace has no passes, \"%s\" isn't written\n", path);
+		return false;
+	}
+
+	return trace->save(path);
+}
+
+void UI::addChild(const std::shared_ptr<WidgetBase>& widget)
+{
+	AllocationScope allocationScope(AllocationTracker::Operation::AddChild);
+
+	if (!_rootWidget)
+	{
+		Unigine::Log::error("noMoPi: %s has no root widget to add a child to\n", _profilerName.get());
+		return;
+	}
+
+	_rootWidget->addChild(widget);
+}
+
+WidgetBase* UI::pick(int32_t x, int32_t y, bool useIndex)
+{
+	if (!_rootWidget)
+		return nullptr;
+
+	const Unigine::Math::ivec4 rootRect = _rootWidget->getLayoutRect();
+	if (x < rootRect.x || y < rootRect.y || x >= rootRect.x + rootRect.z || y >= rootRect.y + rootRect.w)
+		return nullptr;
+
+	return _rootWidget->pick(x - rootRect.x, y - rootRect.y, useIndex);
+}
+
+void UI::pickRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<WidgetBase::RayHit>& hits)
+{
+	if (!_rootWidget)
+		return;
+
+	const Unigine::Math::ivec4 rootRect = _rootWidget->getLayoutRect();
+	_rootWidget->pickRay(origin - Unigine::Math::vec2(static_cast<float>(rootRect.x), static_cast<float>(rootRect.y)), direction, hits);
+
+	std::sort(hits.begin(), hits.end(), [](const WidgetBase::RayHit& a, const WidgetBase::RayHit& b) { return a.distance < b.distance; });
+}
+
+UI::HitTestBenchmark UI::benchmarkHitTest(int32_t queryCount)
+{
+	HitTestBenchmark result;
+	if (!_gui || !_rootWidget || queryCount <= 0)
+		return result;
+
+	const Unigine::Math::ivec2 guiSize = _gui->getSize();
+
+	std::vector<Unigine::Math::ivec2> points(queryCount);
+	Unigine::Math::Random random(0x6e6f6d6f);
+	for (auto& point : points)
+		point = Unigine::Math::ivec2(random.getInt(0, guiSize.x), random.getInt(0, guiSize.y));
+
+	std::vector<WidgetBase*> indexedTargets(queryCount);
+	Unigine::Timer timer;
+
+	timer.begin();
+	for (int32_t i = 0; i < queryCount; i++)
+		indexedTargets[i] = pick(points[i].x, points[i].y, true);
+	result.indexedMilliseconds = timer.endMilliseconds();
+
+	timer.begin();
+	for (int32_t i = 0; i < queryCount; i++)
+	{
+		if (pick(points[i].x, points[i].y, false) != indexedTargets[i])
+			result.mismatchCount++;
+	}
+	result.linearMilliseconds = timer.endMilliseconds();
+
+	result.queryCount = queryCount;
+
+	return result;
+}
+
+void UI::_updateInput()
+{
+	if (!_gui || !_rootWidget)
+		return;
+
+	processPointer(_gui->getMouseX(), _gui->getMouseY(), _gui->getMouseButtons());
+}
+
+void UI::processPointer(int32_t x, int32_t y, int32_t buttons)
+{
+	WidgetBase* target = pick(x, y);
+
+	std::shared_ptr<WidgetBase> hovered = _hoveredWidget.lock();
+	if (hovered.get() != target)
+	{
+		if (hovered)
+			_queueEvent(EventType::Leave, hovered.get());
+
+		_hoveredWidget.reset();
+		if (target)
+		{
+			_hoveredWidget = target->weak_from_this();
+			_queueEvent(EventType::Enter, target);
+		}
+	}
+
+	const int32_t pressed = buttons & ~_mouseButtons;
+	const int32_t released = _mouseButtons & ~buttons;
+	_mouseButtons = buttons;
+
+	if (pressed)
+		_pressedWidget = target ? target->weak_from_this() : std::weak_ptr<WidgetBase>();
+
+	if (released)
+	{
+		std::shared_ptr<WidgetBase> pressedWidget = _pressedWidget.lock();
+		if (pressedWidget && pressedWidget.get() == target)
+			_queueEvent(EventType::Clicked, target, released);
+
+		if (!buttons)
+			_pressedWidget.reset();
+	}
+}
+
+void UI::setDeferredEvents(bool isDeferred)
+{
+	if (!isDeferred)
+		_dispatchEvents();
+
+	_isDeferredEvents = isDeferred;
+}
+
+void UI::_queueEvent(EventType type, WidgetBase* target, int32_t mouse)
+{
+	if (!_isDeferredEvents)
+	{
+		_runEvent(type, target, mouse);
+		return;
+	}
+
+	if (type != EventType::Clicked)
+	{
+		const EventType opposite = type == EventType::Enter ? EventType::Leave : EventType::Enter;
+
+		for (auto it = _eventQueue.rbegin(); it != _eventQueue.rend(); ++it)
+		{
+			if (it->target != target)
+				continue;
+
+			if (it->type == opposite)
+			{
+				_eventQueue.erase(std::next(it).base());
+				return;
+			}
+
+			break;
+		}
+	}
+
+	_eventQueue.push_back({ type, target, target->weak_from_this(), mouse });
+}
+
+void UI::_runEvent(EventType type, WidgetBase* target, int32_t mouse)
+{
+	Interactive* interactive = dynamic_cast<Interactive*>(target);
+
+	if (type == EventType::Enter)
+		interactive->_eventEnter.run(target->getWidget());
+	else if (type == EventType::Leave)
+		interactive->_eventLeave.run(target->getWidget());
+	else
+		interactive->_eventClicked.run(target->getWidget(), mouse);
+}
+
+void UI::_dispatchEvents()
+{
+	// handlers may queue more events and destroy widgets, so liveness is checked per event
+	while (!_eventQueue.empty())
+	{
+		std::swap(_eventQueue, _dispatchedEvents);
+
+		for (const QueuedEvent& event : _dispatchedEvents)
+		{
+			std::shared_ptr<WidgetBase> widget = event.widget.lock();
+			if (widget)
+				_runEvent(event.type, widget.get(), event.mouse);
+		}
+
+		_dispatchedEvents.clear();
+	}
+}
+
+void WidgetContainer::translate()
+{
+	for (auto& child : _childWidgets)
+	{
+		FrameBudgetScope budgetScope(*child);
+		child->translate();
+	}
+}
+
+void WidgetContainer::tick(float deltaTime)
+{
+	for (auto& child : _childWidgets)
+	{
+		FrameBudgetScope budgetScope(*child);
+		child->tick(deltaTime);
+	}
+}
+
+void Label::translate()
+{
+	Unigine::GuiPtr gui = _widget->getGui();
+
+	setText(gui->translate(_keyText));
+
+
+	_calculateMaxFontParams();
+
+	_updateFont(_widget->getWidth());
+}
+
+void Label::collectFootprint(Footprint& footprint) const
+{
+	WidgetBase::collectFootprint(footprint);
+
+	footprint.engineWidgetCount++;
+	footprint.bytes += sizeof(Label) - sizeof(WidgetBase);
+	footprint.addString(_targetText);
+	footprint.addString(_keyText);
+}
+
+void Label::collectGlyphs(GlyphWarmup& warmup) const
+{
+	warmup.addText(_font, _label->getFontSize(), _targetText);
+}
+
+ScrollBox::ScrollBox(const ScaleSettings& scaleSettings) : WidgetContainer(scaleSettings)
+{
+	Unigine::WidgetScrollBoxPtr scroll = Unigine::WidgetScrollBox::create();
+
+	scroll->setVScrollEnabled(true);
+	scroll->setHScrollEnabled(false);
+	Unigine::WidgetScrollPtr scr = scroll->getVScroll();
+	scr->setSliderButton(false);
+	scroll->setBorder(0);
+	/*static Unigine::EventConnection ec;
+	scroll->getEventChanged().connect(ec, [](const Unigine::WidgetPtr& widget) {
+		Unigine::WidgetScrollBoxPtr scr = Unigine::dynamic_ptr_cast<Unigine::WidgetScrollBox>(widget);
+		Unigine::WidgetScrollPtr scroll = scr->getVScroll();
+		Unigine::Log::message("%d %d\n", scr->getVScrollValue() / scr->getScrollScale(), (scr->getVScrollObjectSize() - scr->getVScrollFrameSize()) / scr->getScrollScale());
+		});
+	for (int i = 0; i < 100; i++)
+	{
+		scroll->addChild(Unigine::WidgetButton::create("test"));
+	}*/
+	
+	_widget = scroll;
+}
+
+bool ScrollBox::reset()
+{
+	WidgetContainer::reset();
+
+	_itemCount = 0;
+	Unigine::static_ptr_cast<Unigine::WidgetScrollBox>(_widget)->setVScrollValue(0);
+
+	return true;
+}
+
+void ScrollBox::_beginResize(int32_t width, int32_t height)
+{
+	WidgetContainer::_beginResize(width - 16, height);
+}
+
+ScrollBox* noMoPi::ScrollBox::setVisibleItemCount(int32_t itemCount)
+{
+	_itemCount = itemCount;
+	
+	return this;
+}
+
+Unigine::Math::ivec2 ScrollBox::_getScrollOffset() const
+{
+	Unigine::WidgetScrollBoxPtr scroll = Unigine::static_ptr_cast<Unigine::WidgetScrollBox>(_widget);
+
+	return Unigine::Math::ivec2(0, scroll->getVScrollValue());
+}
+
+void ScrollBox::_planChildren(LayoutJob& job, int32_t width, int32_t height)
+{
+	WidgetContainer::_planChildren(job, width - 16, height);
+}
+
+WidgetContainer::ChildSizing ScrollBox::_beginChildSizing(const Unigine::Math::ivec2& size, const Unigine::Math::ivec4& paddingInPixels) const
+{
+	int32_t height = size.y;
+	int32_t scaledSpacing = static_cast<int32_t>(height * _spacing);
+	height -= (_childWidgets.size() - 2) * scaledSpacing;
+
+	ChildSizing sizing;
+	sizing.parentWidth = size.x;
+	sizing.parentHeight = height / _itemCount;
+
+	return sizing;
+}
+
+bool ScrollBox::_nextChildSize(ChildSizing& sizing, const WidgetBase& child, Unigine::Math::ivec2& size) const
+{
+	size = Unigine::Math::ivec2(sizing.parentWidth, sizing.parentHeight);
+	return true;
+}
+
+EditLine::EditLine(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+{
+	_createWidget();
+}
+
+void EditLine::_createWidget()
+{
+	Unigine::WidgetEditLinePtr _editLine = Unigine::WidgetEditLine::create("test");
+	_editLine->setStyleTextureBackground(Settings::get().getWhiteBackground());
+	_editLine->setBackgroundColor(Unigine::Math::vec4_green);
+	_editLine->setBorderColor(Unigine::Math::vec4_zero);
+
+	_widget = _editLine;
+}
+
+bool EditLine::reset()
+{
+	_layoutPosition = Unigine::Math::ivec2(0, 0);
+
+	if (_font != InvalidResource)
+		_createWidget();
+	else
+		Unigine::static_ptr_cast<Unigine::WidgetEditLine>(_widget)->setText("test");
+
+	_font = InvalidResource;
+	_maxFontSize = 0;
+	_fontSizeUsage.set(InvalidResource, 0);
+
+	return true;
+}
+
+void EditLine::resize(int32_t width, int32_t height)
+{
+	FrameCounters::getCurrent().widgetsLaidOut++;
+
+	// no way to remove the border, so this is a temporary fix
+	_widget->setWidth(width - 4);
+	_widget->setHeight(height - 4);
+
+	_calculateMaxFontSize();
+
+	_widget->setFontSize(_maxFontSize);
+	_fontSizeUsage.set(_font, _maxFontSize);
+}
+
+void noMoPi::EditLine::_calculateMaxFontSize()
+{
+	int32_t height = _widget->getHeight();
+	
+	_maxFontSize = FontSizePolicy::get().quantize(static_cast<int32_t>((height - 5) * _magicMaxFontProportion + 2));
+}
+
+EditLine* EditLine::setDefaultFont(int32_t fontIndex)
+{
+	return setFont(Settings::get().getDefaultFontId(fontIndex));
+}
+
+EditLine* EditLine::setFont(ResourceId font)
+{
+	_font = font;
+	_widget->setFont(Settings::get().getPath(font));
+	_fontSizeUsage.set(_font, _maxFontSize);
+
+	return this;
+}
+
+void EditLine::collectFootprint(Footprint& footprint) const
+{
+	WidgetBase::collectFootprint(footprint);
+
+	footprint.bytes += sizeof(EditLine) - sizeof(WidgetBase);
+}
+
+void EditLine::collectGlyphs(GlyphWarmup& warmup) const
+{
+	Unigine::WidgetEditLinePtr editLine = Unigine::static_ptr_cast<Unigine::WidgetEditLine>(_widget);
+	warmup.addText(_font, _maxFontSize, editLine->getText());
+}
+
+noMoPi::CheckBox::CheckBox(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+{
+	_sprite = Unigine::WidgetSprite::create();
+	Unigine::WidgetSpritePtr& sprite = _sprite;
+
+	TextureAtlas& atlas = TextureAtlas::get();
+	_isAtlased = atlas.contains("border.png") && atlas.contains("tick.png");
+
+	if (_isAtlased)
+	{
+		_backgroundTexture = atlas.getTexture();
+		_tickTexture = atlas.getTexture();
+
+		sprite->setRender(_backgroundTexture);
+		sprite->setLayerTexCoord(0, atlas.getRegion("border.png").texCoord);
+
+		_tickLayer = sprite->addLayer();
+		sprite->setLayerRender(_tickLayer, _tickTexture);
+		sprite->setLayerTexCoord(_tickLayer, atlas.getRegion("tick.png").texCoord);
+	}
+	else
+	{
+		_backgroundTextureId = Settings::get().getTextureId("border.png");
+		_backgroundTexture = TextureCache::get().acquire(_backgroundTextureId);
+		//_backgroundTexture->setSamplerFlags(Unigine::Texture::SAMPLER_FILTER_POINT);
+
+		sprite->setRender(_backgroundTexture);
+
+		_tickTextureId = Settings::get().getTextureId("tick.png");
+		_tickTexture = TextureCache::get().acquire(_tickTextureId);
+		//_tickTexture->setSamplerFlags(Unigine::Texture::SAMPLER_FILTER_POINT);
+
+		_tickLayer = sprite->addLayer();
+		sprite->setLayerRender(_tickLayer, _tickTexture);
+	}
+
+	sprite->setLayerEnabled(_tickLayer, _isChecked);
+
+	_clickConnection = ConnectionPool::get().acquire();
+	sprite->getEventClicked().connect(*_clickConnection, [this](const Unigine::WidgetPtr& widget, int mouse) {
+		setChecked(!_isChecked);
+		});
+
+	_widget = sprite;
+}
+
+bool noMoPi::CheckBox::reset()
+{
+	_layoutPosition = Unigine::Math::ivec2(0, 0);
+
+	// swapping with an empty invoker drops the handlers connected by the previous owner
+	Unigine::EventInvoker<CheckBox*, bool> handlers;
+	Unigine::EventInvoker<CheckBox*, bool>::swap(_eventToggled, handlers);
+
+	setChecked(false);
+
+	return true;
+}
+
+CheckBox* noMoPi::CheckBox::setChecked(bool isChecked)
+{
+	if (isChecked == _isChecked)
+		return this;
+
+	_isChecked = isChecked;
+	_sprite->setLayerEnabled(_tickLayer, _isChecked);
+
+	_eventToggled.run(this, _isChecked);
+
+	return this;
+}
+
+noMoPi::CheckBox::~CheckBox()
+{
+	ConnectionPool::get().release(_clickConnection);
+
+	if (_isAtlased)
+		return;
+
+	TextureCache::get().release(_backgroundTextureId);
+	TextureCache::get().release(_tickTextureId);
+}
+
+void noMoPi::CheckBox::collectFootprint(Footprint& footprint) const
+{
+	WidgetBase::collectFootprint(footprint);
+
+	footprint.bytes += sizeof(CheckBox) - sizeof(WidgetBase);
+	footprint.textureCount += _isAtlased ? 1 : 2;
+}
+
+void noMoPi::CheckBox::collectTextures(std::vector<ResourceId>& textures) const
+{
+	if (_isAtlased)
+		return;
+
+	textures.push_back(_backgroundTextureId);
+	textures.push_back(_tickTextureId);
+}
+
+DataGrid::DataGrid(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+{
+	Unigine::WidgetVBoxPtr vbox = Unigine::WidgetVBox::create();
+	vbox->setBackgroundRender(TextureCache::get().acquire(Settings::get().getWhiteBackgroundId()));
+	vbox->setStencil(true);
+
+	_widget = vbox;
+
+	_measureLabel = Unigine::WidgetLabel::create();
+	_measureLabel->setFontSize(_measureFontSize);
+
+	_rebuildCells();
+}
+
+DataGrid::~DataGrid()
+{
+	TextureCache::get().release(Settings::get().getWhiteBackgroundId());
+}
+
+DataGrid* DataGrid::setColumnCount(int32_t columnCount)
+{
+	_columns.resize(std::max(columnCount, 0));
+
+	for (auto& column : _columns)
+	{
+		column.values.resize(_rowCount);
+		column.widths.resize(_rowCount, -1);
+	}
+
+	_firstVisibleColumn = std::clamp(_firstVisibleColumn, 0, std::max(getColumnCount() - _visibleColumnCount, 0));
+
+	_bindCells();
+
+	return this;
+}
+
+DataGrid* DataGrid::setRowCount(int32_t rowCount)
+{
+	rowCount = std::max(rowCount, 0);
+
+	for (auto& column : _columns)
+	{
+		for (int32_t row = rowCount; row < _rowCount; row++)
+			_dropWidth(column, row);
+
+		column.values.resize(rowCount);
+		column.widths.resize(rowCount, -1);
+
+		for (int32_t row = _rowCount; row < rowCount; row++)
+			column.dirtyRows.push_back(row);
+		column.isMeasureDirty = true;
+	}
+
+	_rowCount = rowCount;
+
+	_firstVisibleRow = std::clamp(_firstVisibleRow, 0, std::max(_rowCount - _visibleRowCount, 0));
+
+	_bindCells();
+
+	return this;
+}
+
+DataGrid* DataGrid::setColumnWeight(int32_t column, float weight)
+{
+	if (!_checkColumn(column))
+		return this;
+
+	_columns[column].weight = weight;
+
+	return this;
+}
+
+DataGrid* DataGrid::setVisibleRowCount(int32_t rowCount)
+{
+	_visibleRowCount = std::max(rowCount, 1);
+	_firstVisibleRow = std::clamp(_firstVisibleRow, 0, std::max(_rowCount - _visibleRowCount, 0));
+	_rebuildCells();
+	resize(getWidget()->getWidth(), getWidget()->getHeight());
+
+	return this;
+}
+
+DataGrid* DataGrid::setVisibleColumnCount(int32_t columnCount)
+{
+	_visibleColumnCount = std::max(columnCount, 1);
+	_firstVisibleColumn = std::clamp(_firstVisibleColumn, 0, std::max(getColumnCount() - _visibleColumnCount, 0));
+	_rebuildCells();
+	resize(getWidget()->getWidth(), getWidget()->getHeight());
+
+	return this;
+}
+
+DataGrid* DataGrid::setFirstVisibleRow(int32_t row)
+{
+	_firstVisibleRow = std::clamp(row, 0, std::max(_rowCount - _visibleRowCount, 0));
+	_bindCells();
+
+	return this;
+}
+
+DataGrid* DataGrid::setFirstVisibleColumn(int32_t column)
+{
+	const int32_t columnCount = getColumnCount();
+	const int32_t firstVisibleColumn = std::clamp(column, 0, std::max(columnCount - _visibleColumnCount, 0));
+
+	if (firstVisibleColumn != _firstVisibleColumn)
+	{
+		_firstVisibleColumn = firstVisibleColumn;
+		resize(getWidget()->getWidth(), getWidget()->getHeight());
+	}
+
+	return this;
+}
+
+DataGrid* DataGrid::setFontSize(float fontSize)
+{
+	_fontSize = std::clamp(fontSize, 0.f, 1.f);
+
+	_updateColumnFonts();
+
+	return this;
+}
+
+DataGrid* DataGrid::setDefaultFont(int32_t fontIndex)
+{
+	return setFont(Settings::get().getDefaultFontId(fontIndex));
+}
+
+DataGrid* DataGrid::setFont(ResourceId font)
+{
+	_font = font;
+
+	const Unigine::String& path = Settings::get().getPath(_font);
+	_measureLabel->setFont(path);
+	for (auto& cell : _cells)
+		cell.label->setFont(path);
+
+	for (auto& column : _columns)
+	{
+		column.measurements.clear();
+		std::fill(column.widths.begin(), column.widths.end(), -1);
+		column.dirtyRows.clear();
+		column.isRescanNeeded = true;
+		column.isMeasureDirty = true;
+	}
+
+	_updateColumnFonts();
+
+	return this;
+}
+
+DataGrid* DataGrid::setCell(int32_t column, int32_t row, const char* value)
+{
+	if (!_checkCell(column, row))
+		return this;
+
+	Column& targetColumn = _columns[column];
+	if (targetColumn.values[row] == value)
+		return this;
+
+	targetColumn.values[row] = value;
+	_invalidateWidth(targetColumn, row);
+
+	if (_isCellVisible(column, row))
+	{
+		const int32_t cellColumn = column - _firstVisibleColumn;
+		const int32_t cellRow = row - _firstVisibleRow;
+		_cells[cellRow * _visibleColumnCount + cellColumn].isDirty = true;
+	}
+
+	return this;
+}
+
+DataGrid* DataGrid::setColumn(int32_t column, const std::vector<Unigine::String>& values)
+{
+	if (!_checkColumn(column))
+		return this;
+
+	if (static_cast<int32_t>(values.size()) > _rowCount)
+		setRowCount(static_cast<int32_t>(values.size()));
+
+	Column& targetColumn = _columns[column];
+	const int32_t valueCount = static_cast<int32_t>(values.size());
+
+	for (int32_t row = 0; row < valueCount; row++)
+	{
+		if (targetColumn.values[row] == values[row])
+			continue;
+
+		targetColumn.values[row] = values[row];
+		_invalidateWidth(targetColumn, row);
+
+		if (_isCellVisible(column, row))
+			_cells[(row - _firstVisibleRow) * _visibleColumnCount + column - _firstVisibleColumn].isDirty = true;
+	}
+
+	return this;
+}
+
+const Unigine::String& DataGrid::getCell(int32_t column, int32_t row) const
+{
+	static const Unigine::String empty;
+
+	return _checkCell(column, row) ? _columns[column].values[row] : empty;
+}
+
+void DataGrid::resize(int32_t width, int32_t height)
+{
+	WidgetBase::resize(width, height);
+
+	FrameCounters::getCurrent().widgetsSkipped += std::max(0, _rowCount * getColumnCount() - static_cast<int32_t>(_cells.size()));
+
+	_rowHeight = height / _visibleRowCount;
+
+	float totalWeight = 0.f;
+	const int32_t visibleColumns = std::min(_visibleColumnCount, getColumnCount() - _firstVisibleColumn);
+	for (int32_t i = 0; i < visibleColumns; i++)
+		totalWeight += _columns[_firstVisibleColumn + i].weight;
+
+	int32_t spaceLeft = width;
+	for (int32_t i = 0; i < _visibleColumnCount; i++)
+	{
+		if (i >= visibleColumns)
+			_columnWidths[i] = 0;
+		else if (i == visibleColumns - 1)
+			_columnWidths[i] = spaceLeft;
+		else
+			_columnWidths[i] = static_cast<int32_t>(width * (_columns[_firstVisibleColumn + i].weight / totalWeight));
+
+		spaceLeft -= _columnWidths[i];
+	}
+
+	for (auto& row : _rows)
+	{
+		row->setWidth(width);
+		row->setHeight(_rowHeight);
+	}
+
+	for (int32_t i = 0; i < static_cast<int32_t>(_cells.size()); i++)
+	{
+		Cell& cell = _cells[i];
+		cell.label->setWidth(_columnWidths[i % _visibleColumnCount]);
+		cell.label->setHeight(_rowHeight);
+	}
+
+	_bindCells();
+	_updateColumnFonts();
+	_refreshCells();
+}
+
+void DataGrid::tick(float deltaTime)
+{
+	_updateColumnFonts();
+	_refreshCells();
+}
+
+void DataGrid::collectFootprint(Footprint& footprint) const
+{
+	WidgetBase::collectFootprint(footprint);
+
+	footprint.engineWidgetCount += static_cast<uint32_t>(_rows.size() + _cells.size() + 1);
+	footprint.textureCount++;
+
+	footprint.bytes += sizeof(DataGrid) - sizeof(WidgetBase);
+	footprint.bytes += _columns.capacity() * sizeof(Column) + _rows.capacity() * sizeof(Unigine::WidgetHBoxPtr);
+	footprint.bytes += _cells.capacity() * sizeof(Cell) + _columnWidths.capacity() * sizeof(int32_t);
+
+	for (const Column& column : _columns)
+	{
+		footprint.bytes += column.values.capacity() * sizeof(Unigine::String) + column.widths.capacity() * sizeof(int32_t);
+		footprint.bytes += column.dirtyRows.capacity() * sizeof(int32_t);
+		footprint.bytes += column.measurements.size() * (sizeof(Unigine::String) + sizeof(int32_t));
+
+		for (const auto& value : column.values)
+			footprint.addString(value);
+	}
+}
+
+void DataGrid::collectGlyphs(GlyphWarmup& warmup) const
+{
+	for (int32_t i = 0; i < _visibleColumnCount; i++)
+	{
+		const int32_t columnIndex = _firstVisibleColumn + i;
+		if (columnIndex >= getColumnCount())
+			break;
+
+		const Column& column = _columns[columnIndex];
+		for (const auto& value : column.values)
+			warmup.addText(_font, column.fontSize, value);
+	}
+}
+
+void DataGrid::_rebuildCells()
+{
+	for (auto& row : _rows)
+		_widget->removeChild(row);
+
+	_rows.clear();
+	_cells.clear();
+	_columnWidths.assign(_visibleColumnCount, 0);
+
+	for (int32_t row = 0; row < _visibleRowCount; row++)
+	{
+		Unigine::WidgetHBoxPtr hbox = Unigine::WidgetHBox::create();
+
+		for (int32_t column = 0; column < _visibleColumnCount; column++)
+		{
+			Cell cell;
+			cell.label = Unigine::WidgetLabel::create();
+			cell.label->setTextAlign(Unigine::Gui::ALIGN_LEFT);
+			if (_font != InvalidResource)
+				cell.label->setFont(Settings::get().getPath(_font));
+
+			hbox->addChild(cell.label);
+			_cells.push_back(cell);
+		}
+
+		_rows.push_back(hbox);
+		_widget->addChild(hbox);
+	}
+
+	for (auto& column : _columns)
+		column.fontSize = 0;
+
+	_bindCells();
+}
+
+void DataGrid::_bindCells()
+{
+	for (int32_t i = 0; i < static_cast<int32_t>(_cells.size()); i++)
+	{
+		Cell& cell = _cells[i];
+		const int32_t row = _firstVisibleRow + i / _visibleColumnCount;
+		const int32_t column = _firstVisibleColumn + i % _visibleColumnCount;
+
+		if (cell.row != row || cell.column != column)
+		{
+			cell.row = row;
+			cell.column = column;
+			cell.isDirty = true;
+		}
+	}
+}
+
+void DataGrid::_measureColumn(Column& column)
+{
+	if (column.measurements.size() > _maxCachedMeasurements)
+		column.measurements.clear();
+
+	// fonts are loaded per gui, so measure in the one the grid draws in
+	Unigine::GuiPtr gui = _widget->getGui();
+	if (gui && _measureLabel->getGui() != gui)
+		_measureLabel->setGui(gui);
+
+	if (column.isRescanNeeded)
+	{
+		column.widestText = 0;
+		column.widestCount = 0;
+		for (int32_t row = 0; row < _rowCount; row++)
+			_measureRow(column, row);
+
+		column.isRescanNeeded = false;
+	}
+	else
+	{
+		for (int32_t row : column.dirtyRows)
+		{
+			if (row < _rowCount && column.widths[row] < 0)
+				_measureRow(column, row);
+		}
+	}
+
+	column.dirtyRows.clear();
+	column.isMeasureDirty = false;
+}
+
+void DataGrid::_measureRow(Column& column, int32_t row)
+{
+	int32_t& width = column.widths[row];
+	if (width < 0)
+	{
+		const Unigine::String& value = column.values[row];
+
+		FrameCounters& counters = FrameCounters::getCurrent();
+
+		auto it = column.measurements.find(value);
+		if (it != column.measurements.end())
+		{
+			width = it->data;
+			counters.measureCacheHits++;
+		}
+		else
+		{
+			width = _measureLabel->getTextRenderSize(value).x;
+			column.measurements.append(value, width);
+			counters.measureCacheMisses++;
+			counters.textMeasurements++;
+		}
+	}
+
+	if (width > column.widestText)
+	{
+		column.widestText = width;
+		column.widestCount = 1;
+	}
+	else if (width == column.widestText)
+		column.widestCount++;
+}
+
+void DataGrid::_invalidateWidth(Column& column, int32_t row)
+{
+	if (column.widths[row] < 0)
+		return;
+
+	_dropWidth(column, row);
+	column.dirtyRows.push_back(row);
+	column.isMeasureDirty = true;
+}
+
+void DataGrid::_dropWidth(Column& column, int32_t row)
+{
+	int32_t& width = column.widths[row];
+	if (width >= 0 && width == column.widestText && --column.widestCount == 0)
+		column.isRescanNeeded = true;
+
+	width = -1;
+}
+
+void DataGrid::_updateColumnFonts()
+{
+	const int32_t maxFontSize = static_cast<int32_t>(_rowHeight * _fontSize);
+
+	for (int32_t i = 0; i < _visibleColumnCount; i++)
+	{
+		const int32_t columnIndex = _firstVisibleColumn + i;
+		if (columnIndex >= getColumnCount())
+			break;
+
+		Column& column = _columns[columnIndex];
+		if (column.isMeasureDirty)
+			_measureColumn(column);
+
+		// text width scales linearly with the font size, so the reference measurement is enough
+		int32_t fontSize = maxFontSize;
+		if (column.widestText > 0)
+			fontSize = std::min(fontSize, _columnWidths[i] * _measureFontSize / column.widestText);
+		fontSize = FontSizePolicy::get().quantize(fontSize);
+
+		if (fontSize == column.fontSize)
+			continue;
+
+		column.fontSize = fontSize;
+		for (int32_t row = 0; row < _visibleRowCount; row++)
+			_cells[row * _visibleColumnCount + i].label->setFontSize(fontSize);
+	}
+}
+
+void DataGrid::_refreshCells()
+{
+	for (auto& cell : _cells)
+	{
+		if (!cell.isDirty)
+			continue;
+
+		if (cell.row < _rowCount && cell.column < getColumnCount())
+			cell.label->setText(_columns[cell.column].values[cell.row]);
+		else
+			cell.label->setText("");
+
+		cell.isDirty = false;
+	}
+}
+
+bool DataGrid::_isCellVisible(int32_t column, int32_t row) const
+{
+	return row >= _firstVisibleRow && row < _firstVisibleRow + _visibleRowCount
+		&& column >= _firstVisibleColumn && column < _firstVisibleColumn + _visibleColumnCount;
+}
+
+bool DataGrid::_checkColumn(int32_t column) const
+{
+	if (column >= 0 && column < getColumnCount())
+		return true;
+
+	Unigine::Log::error("noMoPi: DataGrid column %d is outside of its %d columns\n", column, getColumnCount());
+	return false;
+}
+
+bool DataGrid::_checkCell(int32_t column, int32_t row) const
+{
+	if (!_checkColumn(column))
+		return false;
+
+	if (row >= 0 && row < _rowCount)
+		return true;
+
+	Unigine::Log::error("noMoPi: DataGrid row %d is outside of its %d rows\n", row, _rowCount);
+	return false;
+}
+
+void GlyphWarmup::addText(ResourceId font, int32_t fontSize, const char* text)
+{
+	if (fontSize <= 0 || !text)
+		return;
+
+	Batch& batch = _getBatch(font, fontSize);
+
+	for (const char* c = text; *c;)
+	{
+		unsigned int code = 0;
+		c += Unigine::String::utf8ToUnicode(c, code);
+
+		if (code != '\n')
+			batch.codes.insert(code);
+	}
+}
+
+void GlyphWarmup::addLayout(const std::shared_ptr<WidgetBase>& widget)
+{
+	widget->collectGlyphs(*this);
+}
+
+bool GlyphWarmup::addDictionary(const char* dictionary, const char* language, ResourceId font, const std::vector<int32_t>& fontSizes)
+{
+	Unigine::XmlPtr xml = Unigine::Xml::create();
+	if (!xml->load(Settings::get().getPath(Settings::get().getLocalizationId(dictionary))))
+	{
+		Unigine::Log::error("noMoPi: can't load dictionary \"%s\"\n", dictionary);
+		return false;
+	}
+
+	for (int32_t i = 0; i < xml->getNumChildren(); i++)
+	{
+		Unigine::XmlPtr message = xml->getChild(i);
+		int32_t translation = message->findChild(language);
+		if (translation < 0)
+			continue;
+
+		const char* text = message->getChild(translation)->getData();
+		for (int32_t fontSize : fontSizes)
+			addText(font, fontSize, text);
+	}
+
+	return true;
+}
+
+GlyphWarmup::Report GlyphWarmup::warm()
+{
+	Report report;
+
+	const long long start = Unigine::Time::get();
+
+	Unigine::WidgetLabelPtr label = Unigine::WidgetLabel::create();
+	ResourceId labelFont = InvalidResource;
+	Unigine::String text;
+
+	for (auto& batch : _batches)
+	{
+		if (batch.font != labelFont)
+		{
+			// widgets without a font render with the gui default, which only a label that never had one set uses too
+			if (batch.font == InvalidResource)
+				label = Unigine::WidgetLabel::create();
+			else
+				label->setFont(Settings::get().getPath(batch.font));
+
+			labelFont = batch.font;
+		}
+
+		label->setFontSize(batch.fontSize);
+
+		text.clear();
+		for (const auto& code : batch.codes)
+		{
+			char utf8[8] = {};
+			Unigine::String::unicodeToUtf8(code.key, utf8);
+			text += utf8;
+		}
+
+		// measuring makes the font rasterize every glyph of the text at this size
+		label->getTextRenderSize(text);
+		FrameCounters::getCurrent().textMeasurements++;
+
+		report.glyphCount += static_cast<int32_t>(batch.codes.size());
+		report.fontSizeCount++;
+	}
+
+	report.milliseconds = Unigine::Time::microsecondsToMilliseconds(Unigine::Time::get() - start);
+
+	clear();
+
+	return report;
+}
+
+void GlyphWarmup::clear()
+{
+	_batches.clear();
+	_batchIndices.clear();
+}
+
+GlyphWarmup::Batch& GlyphWarmup::_getBatch(ResourceId font, int32_t fontSize)
+{
+	const Unigine::Math::ivec2 key(font, fontSize);
+
+	auto it = _batchIndices.find(key);
+	if (it != _batchIndices.end())
+		return _batches[it->data];
+
+	_batchIndices.append(key, static_cast<int32_t>(_batches.size()));
+	_batches.emplace_back();
+
+	Batch& batch = _batches.back();
+	batch.font = font;
+	batch.fontSize = fontSize;
+
+	return batch;
+}
+
+FontSizePolicy* FontSizePolicy::setExact()
+{
+	_mode = Mode::Exact;
+	_sizes.clear();
+
+	return this;
+}
+
+FontSizePolicy* FontSizePolicy::setLadder(float ratio, int32_t minSize, int32_t maxSize)
+{
+	if (ratio <= 1.f || minSize <= 0 || maxSize < minSize)
+	{
+		Unigine::Log::error("noMoPi: invalid font size ladder (ratio %f, sizes %d..%d)\n", ratio, minSize, maxSize);
+		return this;
+	}
+
+	_mode = Mode::Ladder;
+	_sizes.clear();
+
+	float size = static_cast<float>(minSize);
+	while (size <= maxSize)
+	{
+		const int32_t step = static_cast<int32_t>(size);
+		if (_sizes.empty() || _sizes.back() != step)
+			_sizes.push_back(step);
+
+		size *= ratio;
+	}
+
+	return this;
+}
+
+FontSizePolicy* FontSizePolicy::setBuckets(int32_t count, int32_t minSize, int32_t maxSize)
+{
+	if (count <= 0 || minSize <= 0 || maxSize < minSize)
+	{
+		Unigine::Log::error("noMoPi: invalid font size buckets (%d, sizes %d..%d)\n", count, minSize, maxSize);
+		return this;
+	}
+
+	_mode = Mode::Buckets;
+	_sizes.clear();
+
+	for (int32_t i = 0; i < count; i++)
+	{
+		const int32_t step = count > 1 ? minSize + (maxSize - minSize) * i / (count - 1) : maxSize;
+		if (_sizes.empty() || _sizes.back() != step)
+			_sizes.push_back(step);
+	}
+
+	return this;
+}
+
+int32_t FontSizePolicy::quantize(int32_t fontSize) const
+{
+	if (_sizes.empty() || fontSize <= _sizes.front())
+		return fontSize;
+
+	auto it = std::upper_bound(_sizes.begin(), _sizes.end(), fontSize);
+
+	return *(it - 1);
+}
+
+void FontSizePolicy::acquire(ResourceId font, int32_t fontSize)
+{
+	const Unigine::Math::ivec2 key(font, fontSize);
+
+	auto it = _liveSizes.find(key);
+	if (it != _liveSizes.end())
+	{
+		it->data++;
+		return;
+	}
+
+	_liveSizes.append(key, 1);
+
+	_statistics.liveSizeCount++;
+	_statistics.peakSizeCount = std::max(_statistics.peakSizeCount, _statistics.liveSizeCount);
+}
+
+void FontSizePolicy::release(ResourceId font, int32_t fontSize)
+{
+	auto it = _liveSizes.find(Unigine::Math::ivec2(font, fontSize));
+	if (it == _liveSizes.end())
+		return;
+
+	if (--it->data == 0)
+	{
+		_liveSizes.erase(it);
+		_statistics.liveSizeCount--;
+	}
+}
+
+uint32_t FontSizePolicy::getLiveSizeCount(ResourceId font) const
+{
+	uint32_t count = 0;
+	for (auto it = _liveSizes.begin(); it != _liveSizes.end(); ++it)
+	{
+		if (it->key.x == font)
+			count++;
+	}
+
+	return count;
+}
+
+void FontSizeUsage::set(ResourceId font, int32_t fontSize)
+{
+	if (font == _font && fontSize == _fontSize)
+		return;
+
+	if (_fontSize > 0)
+		FontSizePolicy::get().release(_font, _fontSize);
+	if (fontSize > 0)
+		FontSizePolicy::get().acquire(font, fontSize);
+
+	_font = font;
+	_fontSize = fontSize;
+}
+
+void SpatialIndex::build(const std::vector<Unigine::Math::ivec4>& rects)
+{
+	clear();
+
+	if (rects.empty())
+		return;
+
+	_bounds.reserve(rects.size());
+	_indices.reserve(rects.size());
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		const Unigine::Math::ivec4& rect = rects[i];
+		_bounds.emplace_back(rect.x, rect.y, rect.x + rect.z, rect.y + rect.w);
+		_indices.push_back(static_cast<int32_t>(i));
+	}
+
+	_nodes.reserve(rects.size() * 2 / _leafSize + 1);
+	_build(0, static_cast<int32_t>(rects.size()));
+}
+
+void SpatialIndex::refit(const std::vector<Unigine::Math::ivec4>& rects)
+{
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		const Unigine::Math::ivec4& rect = rects[i];
+		_bounds[i] = Unigine::Math::ivec4(rect.x, rect.y, rect.x + rect.z, rect.y + rect.w);
+	}
+
+	for (int32_t i = static_cast<int32_t>(_nodes.size()) - 1; i >= 0; i--)
+	{
+		Node& node = _nodes[i];
+		if (node.count)
+		{
+			node.bounds = _bounds[_indices[node.first]];
+			for (int32_t j = node.first + 1; j < node.first + node.count; j++)
+			{
+				const Unigine::Math::ivec4& rect = _bounds[_indices[j]];
+				node.bounds = Unigine::Math::ivec4(std::min(node.bounds.x, rect.x), std::min(node.bounds.y, rect.y), std::max(node.bounds.z, rect.z), std::max(node.bounds.w, rect.w));
+			}
+		}
+		else
+		{
+			const Unigine::Math::ivec4& left = _nodes[i + 1].bounds;
+			const Unigine::Math::ivec4& right = _nodes[node.right].bounds;
+			node.bounds = Unigine::Math::ivec4(std::min(left.x, right.x), std::min(left.y, right.y), std::max(left.z, right.z), std::max(left.w, right.w));
+		}
+	}
+}
+
+void SpatialIndex::clear()
+{
+	_nodes.clear();
+	_indices.clear();
+	_bounds.clear();
+}
+
+int32_t SpatialIndex::_build(int32_t first, int32_t count)
+{
+	Unigine::Math::ivec4 bounds = _bounds[_indices[first]];
+	Unigine::Math::ivec4 centers(INT_MAX, INT_MAX, INT_MIN, INT_MIN);
+
+	for (int32_t i = first; i < first + count; i++)
+	{
+		const Unigine::Math::ivec4& rect = _bounds[_indices[i]];
+		bounds = Unigine::Math::ivec4(std::min(bounds.x, rect.x), std::min(bounds.y, rect.y), std::max(bounds.z, rect.z), std::max(bounds.w, rect.w));
+
+		// doubled centers keep the split exact in integers
+		const int32_t centerX = rect.x + rect.z;
+		const int32_t centerY = rect.y + rect.w;
+		centers = Unigine::Math::ivec4(std::min(centers.x, centerX), std::min(centers.y, centerY), std::max(centers.z, centerX), std::max(centers.w, centerY));
+	}
+
+	const int32_t nodeIndex = static_cast<int32_t>(_nodes.size());
+	_nodes.emplace_back();
+	_nodes[nodeIndex].bounds = bounds;
+
+	if (count <= _leafSize)
+	{
+		_nodes[nodeIndex].first = first;
+		_nodes[nodeIndex].count = count;
+		return nodeIndex;
+	}
+
+	const bool splitX = centers.z - centers.x >= centers.w - centers.y;
+	const int32_t half = count / 2;
+	std::nth_element(_indices.begin() + first, _indices.begin() + first + half, _indices.begin() + first + count,
+		[this, splitX](int32_t a, int32_t b)
+		{
+			const Unigine::Math::ivec4& rectA = _bounds[a];
+			const Unigine::Math::ivec4& rectB = _bounds[b];
+			return splitX ? rectA.x + rectA.z < rectB.x + rectB.z : rectA.y + rectA.w < rectB.y + rectB.w;
+		});
+
+	_build(first, half);
+	const int32_t right = _build(first + half, count - half);
+	_nodes[nodeIndex].right = right;
+
+	return nodeIndex;
+}
+
+void SpatialIndex::queryPoint(int32_t x, int32_t y, std::vector<int32_t>& indices) const
+{
+	if (_nodes.empty())
+		return;
+
+	int32_t stack[64];
+	int32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const Node& node = _nodes[stack[--stackSize]];
+		if (x < node.bounds.x || y < node.bounds.y || x >= node.bounds.z || y >= node.bounds.w)
+			continue;
+
+		if (node.count)
+		{
+			for (int32_t i = node.first; i < node.first + node.count; i++)
+			{
+				const Unigine::Math::ivec4& rect = _bounds[_indices[i]];
+				if (x >= rect.x && y >= rect.y && x < rect.z && y < rect.w)
+					indices.push_back(_indices[i]);
+			}
+			continue;
+		}
+
+		const int32_t nodeIndex = static_cast<int32_t>(&node - _nodes.data());
+		stack[stackSize++] = node.right;
+		stack[stackSize++] = nodeIndex + 1;
+	}
+}
+
+void SpatialIndex::queryRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<RayHit>& hits) const
+{
+	if (_nodes.empty())
+		return;
+
+	const Unigine::Math::vec2 inverseDirection(1.f / direction.x, 1.f / direction.y);
+
+	int32_t stack[64];
+	int32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const int32_t nodeIndex = stack[--stackSize];
+		const Node& node = _nodes[nodeIndex];
+
+		float distance = 0.f;
+		if (!intersectRay(node.bounds, origin, inverseDirection, distance))
+			continue;
+
+		if (node.count)
+		{
+			for (int32_t i = node.first; i < node.first + node.count; i++)
+			{
+				if (intersectRay(_bounds[_indices[i]], origin, inverseDirection, distance))
+					hits.push_back({ _indices[i], distance });
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.right;
+		stack[stackSize++] = nodeIndex + 1;
+	}
+}
+
+// Narrows the ray's entry and exit distance to one slab of a box. A parallel ray is handled apart, multiplying
+// by its infinite inverse gives NaN for an origin on the box edge.
+static bool clipRayToSlab(float low, float high, float origin, float inverseDirection, float& entry, float& exit)
+{
+	if (std::isinf(inverseDirection))
+		return origin >= low && origin <= high;
+
+	const float t0 = (low - origin) * inverseDirection;
+	const float t1 = (high - origin) * inverseDirection;
+
+	entry = std::max(entry, std::min(t0, t1));
+	exit = std::min(exit, std::max(t0, t1));
+
+	return true;
+}
+
+bool SpatialIndex::intersectRay(const Unigine::Math::ivec4& bounds, const Unigine::Math::vec2& origin, const Unigine::Math::vec2& inverseDirection, float& distance)
+{
+	float entry = -std::numeric_limits<float>::infinity();
+	float exit = std::numeric_limits<float>::infinity();
+
+	if (!clipRayToSlab(static_cast<float>(bounds.x), static_cast<float>(bounds.z), origin.x, inverseDirection.x, entry, exit) ||
+		!clipRayToSlab(static_cast<float>(bounds.y), static_cast<float>(bounds.w), origin.y, inverseDirection.y, entry, exit))
+		return false;
+
+	if (exit < 0.f || entry > exit)
+		return false;
+
+	distance = std::max(entry, 0.f);
+
+	return true;
+}
+
+Unigine::EventConnection* ConnectionPool::acquire()
+{
+	_statistics.liveCount++;
+
+	if (!_freeConnections.empty())
+	{
+		Unigine::EventConnection* connection = _freeConnections.back();
+		_freeConnections.pop_back();
+		return connection;
+	}
+
+	_statistics.capacity++;
+
+	return &_connections.emplace_back();
+}
+
+void ConnectionPool::release(Unigine::EventConnection* connection)
+{
+	if (!connection)
+		return;
+
+	connection->disconnect();
+	connection->setEnabled(true);
+
+	_freeConnections.push_back(connection);
+	_statistics.liveCount--;
+}
+
+Interactive::~Interactive()
+{
+	disconnectAll();
+}
+
+void Interactive::disconnectAll()
+{
+	for (Unigine::EventConnection* connection : _connections)
+		ConnectionPool::get().release(connection);
+
+	_connections.clear();
+
+	Unigine::EventInvoker<const Unigine::WidgetPtr&> enter, leave;
+	Unigine::EventInvoker<const Unigine::WidgetPtr&, int> clicked;
+	Unigine::EventInvoker<const Unigine::WidgetPtr&>::swap(_eventEnter, enter);
+	Unigine::EventInvoker<const Unigine::WidgetPtr&>::swap(_eventLeave, leave);
+	Unigine::EventInvoker<const Unigine::WidgetPtr&, int>::swap(_eventClicked, clicked);
+}
+
+Unigine::EventConnection* Interactive::_addConnection()
+{
+	_connections.push_back(ConnectionPool::get().acquire());
+
+	return _connections.back();
+}
+
+Arena::Arena(size_t initialSize) : _upstream(_statistics), _buffer(initialSize, &_upstream)
+{
+}
+
+Arena::~Arena()
+{
+	const uint32_t liveCount = getLiveAllocationCount();
+	UNIGINE_ASSERT(liveCount == 0 && "widgets outlived their arena");
+
+	if (liveCount)
+		Unigine::Log::error("noMoPi: arena destroyed with %u live allocations\n", liveCount);
+}
+
+std::pmr::memory_resource* Arena::getCurrentResource()
+{
+	Arena* arena = _current();
+
+	return arena ? static_cast<std::pmr::memory_resource*>(arena) : std::pmr::get_default_resource();
+}
+
+Arena*& Arena::_current()
+{
+	static thread_local Arena* current = nullptr;
+	return current;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+	_statistics.allocationCount++;
+	_statistics.bytes += bytes;
+
+	return _buffer.allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+	_statistics.deallocationCount++;
+}
+
+void* Arena::Upstream::do_allocate(size_t bytes, size_t alignment)
+{
+	_statistics.chunkCount++;
+	_statistics.chunkBytes += bytes;
+
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void Arena::Upstream::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+WidgetHandle WidgetPool::add(const std::shared_ptr<WidgetBase>& widget)
+{
+	if (!widget)
+		return WidgetHandle();
+
+	int32_t index = 0;
+	if (!_freeSlots.empty())
+	{
+		index = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+	else
+	{
+		if (_slots.size() >= WidgetHandle::IndexMask)
+		{
+			Unigine::Log::error("noMoPi: widget pool is full\n");
+			return WidgetHandle();
+		}
+
+		index = static_cast<int32_t>(_slots.size());
+		_slots.emplace_back();
+	}
+
+	Slot& slot = _slots[index];
+	slot.widget = widget;
+	slot.parent = -1;
+	slot.firstChild = -1;
+	slot.prevSibling = -1;
+	slot.nextSibling = -1;
+	slot.isDestroyed = false;
+
+	_liveCount++;
+
+	return WidgetHandle::make(index, slot.generation);
+}
+
+bool WidgetPool::isValid(WidgetHandle handle) const
+{
+	if (handle.isNull() || handle.getIndex() >= _slots.size())
+		return false;
+
+	const Slot& slot = _slots[handle.getIndex()];
+	if (slot.isDestroyed || !slot.widget || slot.generation != handle.getGeneration())
+		return false;
+
+	// destroy only marks the root, its descendants go stale through it
+	for (int32_t parent = slot.parent; parent != -1; parent = _slots[parent].parent)
+	{
+		if (_slots[parent].isDestroyed)
+			return false;
+	}
+
+	return true;
+}
+
+WidgetBase* WidgetPool::get(WidgetHandle handle) const
+{
+	return isValid(handle) ? _slots[handle.getIndex()].widget.get() : nullptr;
+}
+
+const std::shared_ptr<WidgetBase>& WidgetPool::getShared(WidgetHandle handle) const
+{
+	static const std::shared_ptr<WidgetBase> null;
+
+	return isValid(handle) ? _slots[handle.getIndex()].widget : null;
+}
+
+bool WidgetPool::addChild(WidgetHandle parent, WidgetHandle child)
+{
+	if (!isValid(parent) || !isValid(child))
+		return false;
+
+	const int32_t parentIndex = static_cast<int32_t>(parent.getIndex());
+	const int32_t childIndex = static_cast<int32_t>(child.getIndex());
+
+	Slot& childSlot = _slots[childIndex];
+	if (childSlot.parent != -1)
+	{
+		Unigine::Log::error("noMoPi: widget already has a parent\n");
+		return false;
+	}
+
+	Slot& parentSlot = _slots[parentIndex];
+	parentSlot.widget->addChild(childSlot.widget);
+
+	childSlot.parent = parentIndex;
+	childSlot.prevSibling = -1;
+	childSlot.nextSibling = parentSlot.firstChild;
+	if (parentSlot.firstChild != -1)
+		_slots[parentSlot.firstChild].prevSibling = childIndex;
+	parentSlot.firstChild = childIndex;
+
+	return true;
+}
+
+void WidgetPool::destroy(WidgetHandle handle)
+{
+	if (!isValid(handle))
+		return;
+
+	const int32_t index = static_cast<int32_t>(handle.getIndex());
+	Slot& slot = _slots[index];
+
+	if (slot.parent != -1)
+	{
+		_slots[slot.parent].widget->removeChild(slot.widget.get());
+		_unlink(index);
+	}
+
+	slot.isDestroyed = true;
+	slot.generation++;
+
+	_reclaimQueue.push_back(index);
+}
+
+void WidgetPool::update()
+{
+	int32_t budget = _reclaimBudget;
+
+	while (!_reclaimQueue.empty() && budget-- > 0)
+	{
+		const int32_t index = _reclaimQueue.back();
+		_reclaimQueue.pop_back();
+
+		_reclaim(index);
+	}
+}
+
+void WidgetPool::flush()
+{
+	while (!_reclaimQueue.empty())
+	{
+		const int32_t index = _reclaimQueue.back();
+		_reclaimQueue.pop_back();
+
+		_reclaim(index);
+	}
+}
+
+void WidgetPool::_unlink(int32_t index)
+{
+	Slot& slot = _slots[index];
+
+	if (slot.prevSibling != -1)
+		_slots[slot.prevSibling].nextSibling = slot.nextSibling;
+	else
+		_slots[slot.parent].firstChild = slot.nextSibling;
+
+	if (slot.nextSibling != -1)
+		_slots[slot.nextSibling].prevSibling = slot.prevSibling;
+
+	slot.parent = -1;
+	slot.prevSibling = -1;
+	slot.nextSibling = -1;
+}
+
+void WidgetPool::_reclaim(int32_t index)
+{
+	Slot& slot = _slots[index];
+
+	for (int32_t child = slot.firstChild; child != -1;)
+	{
+		Slot& childSlot = _slots[child];
+		const int32_t next = childSlot.nextSibling;
+
+		childSlot.isDestroyed = true;
+		childSlot.generation++;
+		childSlot.parent = -1;
+		childSlot.prevSibling = -1;
+		childSlot.nextSibling = -1;
+		_reclaimQueue.push_back(child);
+
+		child = next;
+	}
+
+	slot.widget.reset();
+	slot.firstChild = -1;
+	_liveCount--;
+
+	// past the last generation a handle can hold the slot is retired, so old handles never match a reused slot
+	if (slot.generation <= WidgetHandle::GenerationMask)
+	{
+		slot.isDestroyed = false;
+		_freeSlots.push_back(index);
+	}
+}
+
+WidgetRecycler::WidgetRecycler()
+{
+	TextureCache::get();
+	ConnectionPool::get();
+}
+
+void WidgetRecycler::release(std::shared_ptr<WidgetBase> widget)
+{
+	if (!widget)
+		return;
+
+	// pooled, it would be handed out again while its other owners still use it
+	if (widget.use_count() > 1)
+	{
+		Unigine::Log::warning("noMoPi: %s is still referenced elsewhere and isn't recycled\n", getShortTypeName(*widget));
+		return;
+	}
+
+	if (widget->isArenaAllocated())
+	{
+		Unigine::Log::error("noMoPi: %s was allocated from an arena and can't be recycled\n", getShortTypeName(*widget));
+		return;
+	}
+
+	std::vector<std::shared_ptr<WidgetBase>> children;
+	if (WidgetContainer* container = dynamic_cast<WidgetContainer*>(widget.get()))
+	{
+		children.assign(container->getChildren().begin(), container->getChildren().end());
+		while (!container->getChildren().empty())
+			container->removeChild(container->getChildren().back().get());
+	}
+
+	if (Interactive* interactive = dynamic_cast<Interactive*>(widget.get()))
+		interactive->disconnectAll();
+
+	if (Unigine::WidgetPtr engineWidget = widget->getWidget())
+	{
+		if (Unigine::WidgetPtr parent = engineWidget->getParent())
+			parent->removeChild(engineWidget);
+		else if (Unigine::GuiPtr gui = engineWidget->getGui(); gui && gui->isChild(engineWidget))
+			gui->removeChild(engineWidget);
+	}
+
+	std::deque<Entry>& pool = _pools[&typeid(*widget)];
+
+	if (pool.size() < _maxPerType && widget->reset())
+	{
+		pool.push_back({ std::move(widget), Unigine::Time::get() });
+		_statistics.pooledCount++;
+	}
+
+	for (auto& child : children)
+		release(std::move(child));
+}
+
+std::shared_ptr<WidgetBase> WidgetRecycler::_acquire(const std::type_info& type, const ScaleSettings& scaleSettings)
+{
+	auto it = _pools.find(&type);
+	if (it == _pools.end() || it->data.empty())
+	{
+		_statistics.createCount++;
+		return nullptr;
+	}
+
+	std::shared_ptr<WidgetBase> widget = std::move(it->data.back().widget);
+	it->data.pop_back();
+
+	widget->setScaleSettings(scaleSettings);
+
+	_statistics.pooledCount--;
+	_statistics.reuseCount++;
+
+	return widget;
+}
+
+void WidgetRecycler::update()
+{
+	const long long oldest = Unigine::Time::get() - static_cast<long long>(_maxIdleTime * static_cast<double>(Unigine::Time::CLOCKS_PER_SECOND));
+
+	for (auto it = _pools.begin(); it != _pools.end(); ++it)
+	{
+		std::deque<Entry>& pool = it->data;
+		while (!pool.empty() && pool.front().releaseTime < oldest)
+		{
+			pool.pop_front();
+			_statistics.pooledCount--;
+			_statistics.trimmedCount++;
+		}
+	}
+}
+
+void WidgetRecycler::trim(uint32_t maxPerType)
+{
+	for (auto it = _pools.begin(); it != _pools.end(); ++it)
+	{
+		std::deque<Entry>& pool = it->data;
+		while (pool.size() > maxPerType)
+		{
+			pool.pop_front();
+			_statistics.pooledCount--;
+			_statistics.trimmedCount++;
+		}
+	}
+}
+
+void WidgetRecycler::clear()
+{
+	trim();
+	_pools.clear();
+}
+
+void Footprint::addString(const Unigine::String& string)
+{
+	// short strings live inside the object and are already part of its size
+	const size_t heapBytes = string.isDynamicallyAllocated() ? static_cast<size_t>(string.space()) : 0;
+
+	stringCount++;
+	stringBytes += heapBytes;
+	bytes += heapBytes;
+}
+
+Footprint& Footprint::operator+=(const Footprint& other)
+{
+	objectCount += other.objectCount;
+	engineWidgetCount += other.engineWidgetCount;
+	stringCount += other.stringCount;
+	stringBytes += other.stringBytes;
+	textureCount += other.textureCount;
+	bytes += other.bytes;
+
+	return *this;
+}
+
+FootprintReport FootprintReport::build(const std::shared_ptr<WidgetBase>& root)
+{
+	FootprintReport report;
+	if (!root)
+		return report;
+
+	struct Pending
+	{
+		const WidgetBase* widget;
+		int32_t parent;
+		int32_t depth;
+	};
+
+	std::vector<Pending> stack;
+	stack.push_back({ root.get(), -1, 0 });
+
+	while (!stack.empty())
+	{
+		const Pending pending = stack.back();
+		stack.pop_back();
+
+		const int32_t index = static_cast<int32_t>(report.nodes.size());
+		Node& node = report.nodes.emplace_back();
+		node.type = getTypeName(typeid(*pending.widget));
+		node.parent = pending.parent;
+		node.depth = pending.depth;
+
+		pending.widget->collectFootprint(node.self);
+		node.total = node.self;
+
+		if (const WidgetContainer* container = dynamic_cast<const WidgetContainer*>(pending.widget))
+		{
+			const auto& children = container->getChildren();
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+				stack.push_back({ it->get(), index, pending.depth + 1 });
+		}
+	}
+
+	for (size_t i = report.nodes.size(); i-- > 1;)
+		report.nodes[report.nodes[i].parent].total += report.nodes[i].total;
+
+	std::vector<ResourceId> textures;
+	root->collectTextures(textures);
+	std::sort(textures.begin(), textures.end());
+	textures.erase(std::unique(textures.begin(), textures.end()), textures.end());
+
+	report.distinctTextureCount = static_cast<uint32_t>(textures.size());
+	for (ResourceId texture : textures)
+		report.textureBytes += TextureCache::get().getBytes(texture);
+
+	return report;
+}
+
+static void addFootprintJson(const Unigine::JsonPtr& json, const char* name, const Footprint& footprint)
+{
+	Unigine::JsonPtr child = json->addChild(name);
+	child->setObject();
+	child->addChild("objects", static_cast<int>(footprint.objectCount));
+	child->addChild("engineWidgets", static_cast<int>(footprint.engineWidgetCount));
+	child->addChild("strings", static_cast<int>(footprint.stringCount));
+	child->addChild("stringBytes", static_cast<double>(footprint.stringBytes));
+	child->addChild("textures", static_cast<int>(footprint.textureCount));
+	child->addChild("bytes", static_cast<double>(footprint.bytes));
+}
+
+static Unigine::JsonPtr buildFootprintJson(const FootprintReport& report)
+{
+	Unigine::JsonPtr json = Unigine::Json::create();
+	json->setObject();
+	json->addChild("distinctTextures", static_cast<int>(report.distinctTextureCount));
+	json->addChild("textureBytes", static_cast<double>(report.textureBytes));
+
+	std::vector<Unigine::JsonPtr> nodes(report.nodes.size());
+	std::vector<Unigine::JsonPtr> childArrays(report.nodes.size());
+
+	for (size_t i = 0; i < report.nodes.size(); i++)
+	{
+		const FootprintReport::Node& node = report.nodes[i];
+
+		Unigine::JsonPtr item;
+		if (node.parent < 0)
+			item = json->addChild("root");
+		else
+		{
+			Unigine::JsonPtr& children = childArrays[node.parent];
+			if (!children)
+			{
+				children = nodes[node.parent]->addChild("children");
+				children->setArray();
+			}
+			item = children->addChild();
+		}
+
+		item->setObject();
+		item->addChild("type", node.type.get());
+		addFootprintJson(item, "self", node.self);
+		addFootprintJson(item, "total", node.total);
+
+		nodes[i] = item;
+	}
+
+	return json;
+}
+
+Unigine::String FootprintReport::toJson() const
+{
+	return buildFootprintJson(*this)->getFormattedSubTree();
+}
+
+bool FootprintReport::saveJson(const char* path) const
+{
+	if (!buildFootprintJson(*this)->save(path))
+	{
+		Unigine::Log::error("noMoPi: can't save footprint report to \"%s\"\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+Sparkline::Sparkline(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings)
+{
+	_canvas = Unigine::WidgetCanvas::create();
+	_line = _canvas->addLine();
+	_widget = _canvas;
+
+	setHistoryLength(120);
+}
+
+Sparkline* Sparkline::setHistoryLength(int32_t length)
+{
+	_values.assign(std::max(length, 2), 0.f);
+	_head = 0;
+	_count = 0;
+	_canvas->clearLinePoints(_line);
+
+	return this;
+}
+
+Sparkline* Sparkline::setColor(const Unigine::Math::vec4& color)
+{
+	_canvas->setLineColor(_line, color);
+
+	return this;
+}
+
+Sparkline* Sparkline::push(float value)
+{
+	const int32_t length = static_cast<int32_t>(_values.size());
+
+	_values[_head] = value;
+	_head = (_head + 1) % length;
+	_count = std::min(_count + 1, length);
+
+	_updatePoints();
+
+	return this;
+}
+
+void Sparkline::resize(int32_t width, int32_t height)
+{
+	WidgetBase::resize(width, height);
+
+	_updatePoints();
+}
+
+void Sparkline::collectFootprint(Footprint& footprint) const
+{
+	WidgetBase::collectFootprint(footprint);
+
+	footprint.bytes += sizeof(Sparkline) - sizeof(WidgetBase) + _values.capacity() * sizeof(float);
+}
+
+void Sparkline::_updatePoints()
+{
+	const int32_t length = static_cast<int32_t>(_values.size());
+	const int32_t oldest = (_head - _count + length) % length;
+
+	float maxValue = 0.f;
+	for (int32_t i = 0; i < _count; i++)
+		maxValue = std::max(maxValue, _values[(oldest + i) % length]);
+
+	const float width = static_cast<float>(_widget->getWidth());
+	const float height = static_cast<float>(_widget->getHeight());
+	const float scale = maxValue > 0.f ? height / maxValue : 0.f;
+	const float step = width / (length - 1);
+
+	const int32_t pointCount = _canvas->getNumLinePoints(_line);
+	for (int32_t i = 0; i < _count; i++)
+	{
+		const Unigine::Math::vec2 point(width - (_count - 1 - i) * step, height - _values[(oldest + i) % length] * scale);
+
+		if (i < pointCount)
+			_canvas->setLinePoint(_line, i, point);
+		else
+			_canvas->addLinePoint(_line, point);
+	}
+}
+
+static const char* const overlayMetricNames[] = {
+	"layout ms",
+	"tick ms",
+	"laid out",
+	"skipped",
+	"measured",
+	"cache hit %",
+	"allocations",
+	"engine widgets",
+};
+
+PerformanceOverlay::PerformanceOverlay()
+{
+	_root = VBox::create();
+	_root->setBackgroundEnabled(true)
+		->setBackgroundColor(0.f, 0.f, 0.f, 0.75f)
+		->setPadding(0.02f, 0.02f, 0.03f, 0.03f)
+		->setSpacing(0.01f);
+
+	const Unigine::Math::vec4 colors[] = {
+		Unigine::Math::vec4(1.f, 0.8f, 0.2f, 1.f),
+		Unigine::Math::vec4(0.2f, 0.8f, 1.f, 1.f),
+	};
+
+	for (size_t i = 0; i < static_cast<size_t>(Metric::Count); i++)
+	{
+		Row& row = _rows[i];
+
+		row.label = Label::create(ScaleSettings(ScaleType::Fill, 1.5f));
+		row.label->setTextAlign(Align::Left, Align::Center);
+
+		row.sparkline = Sparkline::create();
+		row.sparkline->setColor(colors[i % 2]);
+
+		auto hbox = HBox::create();
+		hbox->setSpacing(0.02f);
+		hbox->addChild(row.label);
+		hbox->addChild(row.sparkline);
+		_root->addChild(hbox);
+
+		// fixed width text keeps the font size picked at layout valid for every later value
+		_setValue(static_cast<Metric>(i), 0.f);
+	}
+}
+
+PerformanceOverlay* PerformanceOverlay::setSize(float width, float height)
+{
+	_width = std::clamp(width, 0.f, 1.f);
+	_height = std::clamp(height, 0.f, 1.f);
+
+	return this;
+}
+
+PerformanceOverlay* PerformanceOverlay::setHistoryLength(int32_t frameCount)
+{
+	for (Row& row : _rows)
+		row.sparkline->setHistoryLength(frameCount);
+
+	return this;
+}
+
+void PerformanceOverlay::resize(int32_t guiWidth, int32_t guiHeight)
+{
+	const int32_t width = static_cast<int32_t>(guiWidth * _width);
+	const int32_t height = static_cast<int32_t>(guiHeight * _height);
+
+	_root->resize(width, height);
+	_root->getWidget()->setPosition(guiWidth - width, 0);
+}
+
+void PerformanceOverlay::update(UI& ui, float deltaTime)
+{
+	const FrameStatistics& statistics = ui.getFrameStatistics();
+	const FrameCounters& counters = statistics.counters;
+
+	_footprintTimer -= deltaTime;
+	if (_footprintTimer <= 0.f)
+	{
+		_footprintTimer = _footprintInterval;
+
+		const FootprintReport report = ui.getFootprint();
+		_engineWidgetCount = report.nodes.empty() ? 0 : report.nodes.front().total.engineWidgetCount;
+	}
+
+	const int32_t lookupCount = counters.measureCacheHits + counters.measureCacheMisses;
+
+	_setValue(Metric::LayoutTime, static_cast<float>(statistics.layoutMilliseconds));
+	_setValue(Metric::TickTime, static_cast<float>(statistics.tickMilliseconds));
+	_setValue(Metric::WidgetsLaidOut, static_cast<float>(counters.widgetsLaidOut));
+	_setValue(Metric::WidgetsSkipped, static_cast<float>(counters.widgetsSkipped));
+	_setValue(Metric::TextMeasurements, static_cast<float>(counters.textMeasurements));
+	_setValue(Metric::MeasureCacheHitRate, lookupCount ? 100.f * counters.measureCacheHits / lookupCount : 100.f);
+	_setValue(Metric::Allocations, static_cast<float>(statistics.allocationCount));
+	_setValue(Metric::EngineWidgets, static_cast<float>(_engineWidgetCount));
+}
+
+void PerformanceOverlay::_setValue(Metric metric, float value)
+{
+	Row& row = _rows[static_cast<size_t>(metric)];
+	const char* name = overlayMetricNames[static_cast<size_t>(metric)];
+
+	char text[64];
+	if (value < 0.f)
+		snprintf(text, sizeof(text), "%-15s%10s", name, "n/a");
+	else
+		snprintf(text, sizeof(text), "%-15s%10.2f", name, value);
+
+	row.label->setText(text, false);
+	row.sparkline->push(std::max(value, 0.f));
+}
+
+uint32_t& AllocationTracker::_activeOperations()
+{
+	static thread_local uint32_t operations = 0;
+	return operations;
+}
+
+void AllocationTracker::onAllocate(size_t bytes)
+{
+	const uint32_t operations = _activeOperations();
+	if (!operations)
+		return;
+
+	AllocationTracker& tracker = get();
+	for (size_t i = 0; i < static_cast<size_t>(Operation::Count); i++)
+	{
+		if (operations & (1u << i))
+		{
+			tracker._counters[i].allocationCount++;
+			tracker._counters[i].bytes += bytes;
+		}
+	}
+}
+
+void AllocationTracker::setTickAllocationCheck(bool isEnabled, uint32_t warmupTickCount)
+{
+	_isTickCheckEnabled = isEnabled;
+	_warmupTickCount = warmupTickCount;
+	_checkedTickCount = 0;
+	_failedTickCount = 0;
+}
+
+void AllocationTracker::resetCounters()
+{
+	for (Counters& counters : _counters)
+		counters = Counters();
+}
+
+AllocationScope::AllocationScope(AllocationTracker::Operation operation) : _operation(operation)
+{
+	AllocationTracker& tracker = AllocationTracker::get();
+	if (!tracker.isEnabled())
+		return;
+
+	const AllocationTracker::Counters& counters = tracker.getCounters(operation);
+	_allocationCount = counters.allocationCount;
+	_bytes = counters.bytes;
+	_isTracking = true;
+
+	uint32_t& operations = AllocationTracker::_activeOperations();
+	_previousOperations = operations;
+	operations |= 1u << static_cast<uint32_t>(operation);
+}
+
+AllocationScope::~AllocationScope()
+{
+	if (!_isTracking)
+		return;
+
+	// stop tracking first, so reporting a failure isn't counted as part of the operation
+	AllocationTracker::_activeOperations() = _previousOperations;
+
+	AllocationTracker& tracker = AllocationTracker::get();
+	AllocationTracker::Counters& counters = tracker._counters[static_cast<size_t>(_operation)];
+	counters.callCount++;
+
+	if (_operation != AllocationTracker::Operation::Tick || !tracker._isTickCheckEnabled)
+		return;
+
+	if (++tracker._checkedTickCount <= tracker._warmupTickCount)
+		return;
+
+	const uint64_t allocationCount = counters.allocationCount - _allocationCount;
+	if (allocationCount)
+	{
+		tracker._failedTickCount++;
+		Unigine::Log::error("noMoPi: steady-state tick allocated %llu times, %llu bytes\n",
+			static_cast<unsigned long long>(allocationCount), static_cast<unsigned long long>(counters.bytes - _bytes));
+	}
+}
+
+template<typename T>
+static void writeTraceValue(std::vector<uint8_t>& bytes, const T& value)
+{
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(&value);
+	bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+static void writeTraceString(std::vector<uint8_t>& bytes, const Unigine::String& string)
+{
+	writeTraceValue(bytes, static_cast<uint32_t>(string.size()));
+	bytes.insert(bytes.end(), string.get(), string.get() + string.size());
+}
+
+static bool isTraceContainer(LayoutTrace::NodeType type)
+{
+	return type == LayoutTrace::NodeType::VBox || type == LayoutTrace::NodeType::HBox || type == LayoutTrace::NodeType::ScrollBox;
+}
+
+static void writeTraceNode(std::vector<uint8_t>& bytes, const LayoutTrace::Node& node)
+{
+	writeTraceValue(bytes, static_cast<uint8_t>(node.type));
+	writeTraceValue(bytes, node.parent);
+	writeTraceValue(bytes, static_cast<uint8_t>(node.scaleSettings.scaleType));
+	writeTraceValue(bytes, node.scaleSettings.scaleFactor);
+
+	if (isTraceContainer(node.type))
+	{
+		for (int32_t i = 0; i < 4; i++)
+			writeTraceValue(bytes, node.padding[i]);
+
+		writeTraceValue(bytes, static_cast<uint8_t>(node.isPaddingEqual));
+		writeTraceValue(bytes, node.spacing);
+		writeTraceValue(bytes, static_cast<uint8_t>(node.ignorePadding));
+
+		if (node.type == LayoutTrace::NodeType::ScrollBox)
+			writeTraceValue(bytes, node.itemCount);
+	}
+	else if (node.type == LayoutTrace::NodeType::Label)
+	{
+		writeTraceString(bytes, node.text);
+		writeTraceValue(bytes, node.fontSize);
+		writeTraceValue(bytes, static_cast<uint8_t>(node.fontWrap));
+		writeTraceValue(bytes, node.fontMaxHSpacing);
+		writeTraceValue(bytes, node.fontMaxVSpacing);
+		writeTraceValue(bytes, node.fontHSpacing);
+		writeTraceValue(bytes, node.fontVSpacing);
+	}
+}
+
+struct TraceReader
+{
+	const std::vector<uint8_t>& bytes;
+	size_t offset = 0;
+	bool isValid = true;
+
+	template<typename T>
+	T read()
+	{
+		T value{};
+		if (!isValid || bytes.size() - offset < sizeof(T))
+		{
+			isValid = false;
+			return value;
+		}
+
+		memcpy(&value, bytes.data() + offset, sizeof(T));
+		offset += sizeof(T);
+		return value;
+	}
+
+	uint32_t readCount(size_t minimumItemBytes)
+	{
+		const uint32_t count = read<uint32_t>();
+		if (isValid && count > (bytes.size() - offset) / minimumItemBytes)
+			isValid = false;
+
+		return isValid ? count : 0;
+	}
+
+	Unigine::String readString()
+	{
+		const uint32_t size = readCount(1);
+		if (!isValid)
+			return Unigine::String();
+
+		Unigine::String string(reinterpret_cast<const char*>(bytes.data() + offset), static_cast<int>(size));
+		offset += size;
+		return string;
+	}
+};
+
+static LayoutTrace::Node readTraceNode(TraceReader& reader)
+{
+	LayoutTrace::Node node;
+	node.type = static_cast<LayoutTrace::NodeType>(reader.read<uint8_t>());
+	node.parent = reader.read<int32_t>();
+	node.scaleSettings.scaleType = static_cast<ScaleType>(reader.read<uint8_t>());
+	node.scaleSettings.scaleFactor = reader.read<float>();
+
+	if (node.type > LayoutTrace::NodeType::Leaf || node.scaleSettings.scaleType > ScaleType::PixelPerfect)
+		reader.isValid = false;
+
+	if (isTraceContainer(node.type))
+	{
+		for (int32_t i = 0; i < 4; i++)
+			node.padding[i] = reader.read<float>();
+
+		node.isPaddingEqual = reader.read<uint8_t>() != 0;
+		node.spacing = reader.read<float>();
+		node.ignorePadding = reader.read<uint8_t>() != 0;
+
+		if (node.type == LayoutTrace::NodeType::ScrollBox)
+			node.itemCount = reader.read<int32_t>();
+	}
+	else if (node.type == LayoutTrace::NodeType::Label)
+	{
+		node.text = reader.readString();
+		node.fontSize = reader.read<float>();
+		node.fontWrap = reader.read<uint8_t>() != 0;
+		node.fontMaxHSpacing = reader.read<float>();
+		node.fontMaxVSpacing = reader.read<float>();
+		node.fontHSpacing = reader.read<float>();
+		node.fontVSpacing = reader.read<float>();
+	}
+
+	return node;
+}
+
+bool LayoutTrace::save(const char* path) const
+{
+	std::vector<uint8_t> bytes;
+	writeTraceValue(bytes, Magic);
+	writeTraceValue(bytes, Version);
+
+	writeTraceValue(bytes, static_cast<uint8_t>(fontSizeMode));
+	writeTraceValue(bytes, static_cast<uint32_t>(fontSizes.size()));
+	for (int32_t size : fontSizes)
+		writeTraceValue(bytes, size);
+
+	writeTraceValue(bytes, static_cast<uint32_t>(trees.size()));
+	for (const auto& nodes : trees)
+	{
+		writeTraceValue(bytes, static_cast<uint32_t>(nodes.size()));
+		for (const Node& node : nodes)
+			writeTraceNode(bytes, node);
+	}
+
+	writeTraceValue(bytes, static_cast<uint32_t>(passes.size()));
+	for (const Pass& pass : passes)
+	{
+		writeTraceValue(bytes, pass.guiSize.x);
+		writeTraceValue(bytes, pass.guiSize.y);
+		writeTraceValue(bytes, pass.tree);
+
+		writeTraceValue(bytes, static_cast<uint32_t>(pass.measurements.size()));
+		for (const Unigine::Math::ivec2& size : pass.measurements)
+		{
+			writeTraceValue(bytes, size.x);
+			writeTraceValue(bytes, size.y);
+		}
+
+		writeTraceValue(bytes, static_cast<uint32_t>(pass.results.size()));
+		for (const Result& result : pass.results)
+		{
+			for (int32_t i = 0; i < 4; i++)
+				writeTraceValue(bytes, result.rect[i]);
+
+			writeTraceValue(bytes, result.fontSize);
+		}
+	}
+
+	FILE* file = fopen(path, "wb");
+	const bool isWritten = file && fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	if (file)
+		fclose(file);
+
+	if (!isWritten)
+	{
+		Unigine::Log::error("noMoPi: can't save layout trace to \"%s\"\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+bool LayoutTrace::load(const char* path)
+{
+	*this = LayoutTrace();
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+	{
+		Unigine::Log::error("noMoPi: can't open layout trace \"%s\"\n", path);
+		return false;
+	}
+
+	std::vector<uint8_t> bytes;
+	uint8_t buffer[4096];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		bytes.insert(bytes.end(), buffer, buffer + count);
+
+	fclose(file);
+
+	TraceReader reader{ bytes };
+	if (reader.read<uint32_t>() != Magic || reader.read<uint32_t>() != Version)
+	{
+		Unigine::Log::error("noMoPi: \"%s\" isn't a version %u layout trace\n", path, Version);
+		return false;
+	}
+
+	fontSizeMode = static_cast<FontSizePolicy::Mode>(reader.read<uint8_t>());
+	fontSizes.resize(reader.readCount(sizeof(int32_t)));
+	for (int32_t& size : fontSizes)
+		size = reader.read<int32_t>();
+
+	trees.resize(reader.readCount(sizeof(uint32_t)));
+	for (auto& nodes : trees)
+	{
+		nodes.resize(reader.readCount(10));
+		for (size_t i = 0; i < nodes.size() && reader.isValid; i++)
+		{
+			nodes[i] = readTraceNode(reader);
+
+			if ((i == 0) != (nodes[i].parent < 0) || nodes[i].parent >= static_cast<int32_t>(i))
+				reader.isValid = false;
+		}
+	}
+
+	passes.resize(reader.readCount(20));
+	for (Pass& pass : passes)
+	{
+		pass.guiSize.x = reader.read<int32_t>();
+		pass.guiSize.y = reader.read<int32_t>();
+		pass.tree = reader.read<int32_t>();
+
+		pass.measurements.resize(reader.readCount(sizeof(int32_t) * 2));
+		for (Unigine::Math::ivec2& size : pass.measurements)
+		{
+			size.x = reader.read<int32_t>();
+			size.y = reader.read<int32_t>();
+		}
+
+		pass.results.resize(reader.readCount(sizeof(int32_t) * 5));
+		for (Result& result : pass.results)
+		{
+			for (int32_t i = 0; i < 4; i++)
+				result.rect[i] = reader.read<int32_t>();
+
+			result.fontSize = reader.read<int32_t>();
+		}
+
+		if (pass.tree < 0 || pass.tree >= static_cast<int32_t>(trees.size()) || pass.results.size() != trees[pass.tree].size())
+			reader.isValid = false;
+
+		if (!reader.isValid)
+			break;
+	}
+
+	if (!reader.isValid || fontSizeMode > FontSizePolicy::Mode::Buckets)
+	{
+		Unigine::Log::error("noMoPi: layout trace \"%s\" is truncated or corrupt\n", path);
+		*this = LayoutTrace();
+		return false;
+	}
+
+	return true;
+}
+
+void LayoutTrace::beginPass(const std::shared_ptr<WidgetBase>& root, const Unigine::Math::ivec2& guiSize)
+{
+	if (passes.empty())
+	{
+		fontSizeMode = FontSizePolicy::get()._mode;
+		fontSizes = FontSizePolicy::get()._sizes;
+	}
+
+	_snapshot(root);
+
+	_treeBytes.clear();
+	for (const Node& node : _nodes)
+		writeTraceNode(_treeBytes, node);
+
+	if (trees.empty() || _treeBytes != _lastTreeBytes)
+	{
+		trees.push_back(_nodes);
+		std::swap(_treeBytes, _lastTreeBytes);
+	}
+
+	Pass& pass = passes.emplace_back();
+	pass.guiSize = guiSize;
+	pass.tree = static_cast<int32_t>(trees.size()) - 1;
+
+	_pass = static_cast<int32_t>(passes.size()) - 1;
+	_isReplaying = false;
+	_current() = this;
+}
+
+void LayoutTrace::endPass()
+{
+	_current() = nullptr;
+
+	Pass& pass = passes[_pass];
+	pass.results.reserve(_widgets.size());
+	for (const WidgetBase* widget : _widgets)
+		pass.results.push_back(_getResult(widget));
+
+	_pass = -1;
+}
+
+void LayoutTrace::applyFontSizePolicy() const
+{
+	FontSizePolicy& policy = FontSizePolicy::get();
+	policy._mode = fontSizeMode;
+	policy._sizes = fontSizes;
+}
+
+std::vector<std::shared_ptr<WidgetBase>> LayoutTrace::buildTree(int32_t tree) const
+{
+	std::vector<std::shared_ptr<WidgetBase>> widgets;
+	if (tree < 0 || tree >= static_cast<int32_t>(trees.size()))
+		return widgets;
+
+	widgets.reserve(trees[tree].size());
+	for (const Node& node : trees[tree])
+	{
+		std::shared_ptr<WidgetBase> widget;
+		switch (node.type)
+		{
+		case NodeType::HBox:
+			widget = HBox::create(node.scaleSettings);
+			break;
+		case NodeType::ScrollBox:
+		{
+			auto scrollBox = ScrollBox::create(node.scaleSettings);
+			scrollBox->setVisibleItemCount(node.itemCount);
+			widget = scrollBox;
+			break;
+		}
+		case NodeType::Label:
+		{
+			auto label = Label::create(node.scaleSettings);
+			label->setText(node.text, false)
+				->setFontWrap(node.fontWrap)
+				->setFontMaxHSpacing(node.fontMaxHSpacing)
+				->setFontMaxVSpacing(node.fontMaxVSpacing)
+				->setFontHSpacing(node.fontHSpacing)
+				->setFontVSpacing(node.fontVSpacing)
+				->setFontSize(node.fontSize);
+			widget = label;
+			break;
+		}
+		case NodeType::EditLine:
+			widget = EditLine::create(node.scaleSettings);
+			break;
+		default:
+			widget = VBox::create(node.scaleSettings);
+			break;
+		}
+
+		if (isTraceContainer(node.type))
+		{
+			static_cast<WidgetContainer*>(widget.get())
+				->setPadding(node.padding[0], node.padding[1], node.padding[2], node.padding[3])
+				->setPaddingEqual(node.isPaddingEqual)
+				->setSpacing(node.spacing, node.ignorePadding);
+		}
+
+		if (node.parent >= 0)
+			widgets[node.parent]->addChild(widget);
+
+		widgets.push_back(widget);
+	}
+
+	return widgets;
+}
+
+void LayoutTrace::beginReplay(int32_t pass)
+{
+	_pass = pass;
+	_measurement = 0;
+	_isReplaying = true;
+	_current() = this;
+}
+
+void LayoutTrace::endReplay()
+{
+	_current() = nullptr;
+	_isReplaying = false;
+	_pass = -1;
+}
+
+int32_t LayoutTrace::compareResults(int32_t pass, const std::vector<std::shared_ptr<WidgetBase>>& nodes) const
+{
+	const std::vector<Result>& results = passes[pass].results;
+	const size_t count = std::min(nodes.size(), results.size());
+
+	int32_t mismatchCount = static_cast<int32_t>(std::max(nodes.size(), results.size()) - count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const Result result = _getResult(nodes[i].get());
+		if (result.rect != results[i].rect || result.fontSize != results[i].fontSize)
+			mismatchCount++;
+	}
+
+	return mismatchCount;
+}
+
+Unigine::Math::ivec2 LayoutTrace::measureText(const Unigine::WidgetLabelPtr& label, const Unigine::String& text)
+{
+	LayoutTrace* trace = _current();
+	if (!trace)
+		return label->getTextRenderSize(text);
+
+	Pass& pass = trace->passes[trace->_pass];
+	if (!trace->_isReplaying)
+	{
+		const Unigine::Math::ivec2 size = label->getTextRenderSize(text);
+		pass.measurements.push_back(size);
+		return size;
+	}
+
+	if (trace->_measurement < pass.measurements.size())
+		return pass.measurements[trace->_measurement++];
+
+	return label->getTextRenderSize(text);
+}
+
+LayoutTrace*& LayoutTrace::_current()
+{
+	static thread_local LayoutTrace* current = nullptr;
+	return current;
+}
+
+LayoutTrace::Result LayoutTrace::_getResult(const WidgetBase* widget)
+{
+	Result result;
+	result.rect = widget->getLayoutRect();
+
+	if (const Label* label = dynamic_cast<const Label*>(widget))
+		result.fontSize = label->_label->getFontSize();
+	else if (dynamic_cast<const EditLine*>(widget))
+		result.fontSize = static_cast<const Unigine::WidgetPtr&>(*widget)->getFontSize();
+
+	return result;
+}
+
+void LayoutTrace::_snapshot(const std::shared_ptr<WidgetBase>& root)
+{
+	_nodes.clear();
+	_widgets.clear();
+
+	if (!root)
+		return;
+
+	struct Pending
+	{
+		const WidgetBase* widget;
+		int32_t parent;
+	};
+
+	std::vector<Pending> stack;
+	stack.push_back({ root.get(), -1 });
+
+	while (!stack.empty())
+	{
+		const Pending pending = stack.back();
+		stack.pop_back();
+
+		const int32_t index = static_cast<int32_t>(_nodes.size());
+		Node& node = _nodes.emplace_back();
+		node.parent = pending.parent;
+		node.scaleSettings = pending.widget->getScaleSettings();
+		_widgets.push_back(pending.widget);
+
+		if (const WidgetContainer* container = dynamic_cast<const WidgetContainer*>(pending.widget))
+		{
+			if (const ScrollBox* scrollBox = dynamic_cast<const ScrollBox*>(container))
+			{
+				node.type = NodeType::ScrollBox;
+				node.itemCount = scrollBox->_itemCount;
+			}
+			// containers lay out by their engine widget type, so custom ones replay as the box they are built on
+			else if (container->_widget->getType() == Unigine::Widget::TYPE::WIDGET_HBOX)
+				node.type = NodeType::HBox;
+			else
+				node.type = NodeType::VBox;
+
+			node.padding = container->_padding;
+			node.isPaddingEqual = container->_isPaddingEqual;
+			node.spacing = container->_spacing;
+			node.ignorePadding = container->_ignorePadding;
+
+			const auto& children = container->getChildren();
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+				stack.push_back({ it->get(), index });
+		}
+		else if (const Label* label = dynamic_cast<const Label*>(pending.widget))
+		{
+			node.type = NodeType::Label;
+			node.text = label->_targetText;
+			node.fontSize = label->_fontSize;
+			node.fontWrap = label->_fontWrap;
+			node.fontMaxHSpacing = label->_fontMaxHSpacing;
+			node.fontMaxVSpacing = label->_fontMaxVSpacing;
+			node.fontHSpacing = label->_fontHSpacing;
+			node.fontVSpacing = label->_fontVSpacing;
+		}
+		else if (dynamic_cast<const EditLine*>(pending.widget))
+			node.type = NodeType::EditLine;
+	}
+}
+
+FrameBudgetScope::FrameBudgetScope(WidgetBase& widget)
+{
+	if (!_isTiming())
+		return;
+
+	_widget = &widget;
+	_begin = Unigine::Time::get();
+}
+
+FrameBudgetScope::FrameBudgetScope(WidgetBase& widget, bool isTiming) : _wasTiming(_isTiming()), _isRoot(true)
+{
+	_isTiming() = isTiming;
+	if (!isTiming)
+		return;
+
+	_widget = &widget;
+	_begin = Unigine::Time::get();
+}
+
+FrameBudgetScope::~FrameBudgetScope()
+{
+	if (_widget)
+		_widget->_passMicroseconds = Unigine::Time::get() - _begin;
+
+	if (_isRoot)
+		_isTiming() = _wasTiming;
+}
+
+bool& FrameBudgetScope::_isTiming()
+{
+	static thread_local bool isTiming = false;
+	return isTiming;
+}
+
+void LayoutJob::start(const std::shared_ptr<WidgetBase>& root, int32_t width, int32_t height)
+{
+	cancel();
+
+	if (!root)
+		return;
+
+	_isRunning = true;
+	push(root, width, height);
+}
+
+bool LayoutJob::step(long long maxMicroseconds)
+{
+	if (!_isRunning)
+		return false;
+
+	if (_queue.empty())
+		return true;
+
+	NOMOPI_PROFILER_SCOPED("noMoPi::LayoutJob::step");
+
+	const long long begin = Unigine::Time::get();
+
+	// children are pushed in reverse, so text is measured in the same order as a recursive resize
+	constexpr uint32_t batchSize = 32;
+	uint32_t plannedCount = 0;
+	do
+	{
+		LayoutRecord& record = _records.emplace_back(std::move(_queue.back()));
+		_queue.pop_back();
+
+		const size_t firstChild = _queue.size();
+		record.widget->planLayout(*this, record);
+		std::reverse(_queue.begin() + firstChild, _queue.end());
+	} while (!_queue.empty() && (++plannedCount % batchSize || Unigine::Time::get() - begin < maxMicroseconds));
+
+	return _queue.empty();
+}
+
+bool LayoutJob::commit()
+{
+	if (!isPlanned())
+		return false;
+
+	NOMOPI_PROFILER_SCOPED("noMoPi::LayoutJob::commit");
+
+	for (const LayoutRecord& record : _records)
+		record.widget->commitLayout(record);
+
+	for (auto it = _records.rbegin(); it != _records.rend(); ++it)
+	{
+		if (it->isContainer)
+			static_cast<WidgetContainer*>(it->widget.get())->_placeChildren();
+	}
+
+	cancel();
+	return true;
+}
+
+void LayoutJob::cancel()
+{
+	_queue.clear();
+	_records.clear();
+	_isRunning = false;
+}
+
+void LayoutJob::push(const std::shared_ptr<WidgetBase>& widget, int32_t width, int32_t height)
+{
+	LayoutRecord& record = _queue.emplace_back();
+	record.widget = widget;
+	record.width = width;
+	record.height = height;
+}
+
+const Unigine::WidgetLabelPtr& LayoutJob::getMeasureLabel(ResourceId font)
+{
+	auto it = _measureLabels.find(font);
+	if (it != _measureLabels.end())
+		return it->data;
+
+	Unigine::WidgetLabelPtr label = Unigine::WidgetLabel::create();
+	if (font != InvalidResource)
+		label->setFont(Settings::get().getPath(font));
+
+	_measureLabels.append(font, label);
+	return _measureLabels.find(font)->data;
+}
+
+static const char* const descriptionElementNames[] = { "hbox", "vbox", "scrollbox", "label", "editline", "checkbox" };
+// in Align order
+static const char* const descriptionAlignNames[] = { "top", "bottom", "left", "right", "center" };
+
+static void skipDescriptionSpaces(const char*& cursor)
+{
+	while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n')
+		cursor++;
+}
+
+static bool isDescriptionEnd(const char* cursor)
+{
+	skipDescriptionSpaces(cursor);
+	return *cursor == '\0';
+}
+
+// Consumes the next whitespace separated word if it is the expected one
+static bool readDescriptionWord(const char*& cursor, const char* word)
+{
+	skipDescriptionSpaces(cursor);
+
+	const size_t length = strlen(word);
+	if (strncmp(cursor, word, length) || (cursor[length] && cursor[length] != ' ' && cursor[length] != '\t' && cursor[length] != '\r' && cursor[length] != '\n'))
+		return false;
+
+	cursor += length;
+	return true;
+}
+
+static bool readDescriptionFloats(const char*& cursor, float* values, int32_t count)
+{
+	for (int32_t i = 0; i < count; i++)
+	{
+		char* end = nullptr;
+		values[i] = strtof(cursor, &end);
+		if (end == cursor)
+			return false;
+
+		cursor = end;
+	}
+
+	return true;
+}
+
+static bool readDescriptionInts(const char*& cursor, int32_t* values, int32_t count)
+{
+	for (int32_t i = 0; i < count; i++)
+	{
+		char* end = nullptr;
+		values[i] = static_cast<int32_t>(strtol(cursor, &end, 10));
+		if (end == cursor)
+			return false;
+
+		cursor = end;
+	}
+
+	return true;
+}
+
+static bool parseDescriptionFloat(const char* value, float& result)
+{
+	return readDescriptionFloats(value, &result, 1) && isDescriptionEnd(value);
+}
+
+static bool parseDescriptionBool(const char* value, bool& result)
+{
+	if (readDescriptionWord(value, "true") || readDescriptionWord(value, "1"))
+		result = true;
+	else if (readDescriptionWord(value, "false") || readDescriptionWord(value, "0"))
+		result = false;
+	else
+		return false;
+
+	return isDescriptionEnd(value);
+}
+
+// "fill", "proportional 0.1" or "pixelPerfect", the factor is optional and defaults to 1
+static bool parseDescriptionScale(const char* value, ScaleSettings& scaleSettings)
+{
+	if (readDescriptionWord(value, "fill"))
+		scaleSettings.scaleType = ScaleType::Fill;
+	else if (readDescriptionWord(value, "proportional"))
+		scaleSettings.scaleType = ScaleType::Proportional;
+	else if (readDescriptionWord(value, "pixelPerfect"))
+		scaleSettings.scaleType = ScaleType::PixelPerfect;
+	else
+		return false;
+
+	if (!isDescriptionEnd(value) && !readDescriptionFloats(value, &scaleSettings.scaleFactor, 1))
+		return false;
+
+	return isDescriptionEnd(value);
+}
+
+// One value for every side or four in setPadding order
+static bool parseDescriptionPadding(const char* value, Unigine::Math::vec4& padding)
+{
+	float sides[4] = {};
+	if (!readDescriptionFloats(value, sides, 1))
+		return false;
+
+	if (isDescriptionEnd(value))
+		sides[1] = sides[2] = sides[3] = sides[0];
+	else if (!readDescriptionFloats(value, sides + 1, 3))
+		return false;
+
+	padding = Unigine::Math::vec4(sides[0], sides[1], sides[2], sides[3]);
+	return isDescriptionEnd(value);
+}
+
+// "r g b" or "r g b a" from 0 to 255
+static bool parseDescriptionColor(const char* value, Unigine::Math::ivec4& color)
+{
+	int32_t channels[4] = { 0, 0, 0, 255 };
+	if (!readDescriptionInts(value, channels, 3))
+		return false;
+
+	if (!isDescriptionEnd(value) && !readDescriptionInts(value, channels + 3, 1))
+		return false;
+
+	color = Unigine::Math::ivec4(channels[0], channels[1], channels[2], channels[3]);
+	return isDescriptionEnd(value);
+}
+
+static bool parseDescriptionFiltering(const char* value, int32_t& filtering)
+{
+	if (readDescriptionWord(value, "point"))
+		filtering = Unigine::Texture::SAMPLER_FILTER_POINT;
+	else if (readDescriptionWord(value, "linear"))
+		filtering = Unigine::Texture::SAMPLER_FILTER_LINEAR;
+	else if (readDescriptionWord(value, "bilinear"))
+		filtering = Unigine::Texture::SAMPLER_FILTER_BILINEAR;
+	else if (readDescriptionWord(value, "trilinear"))
+		filtering = Unigine::Texture::SAMPLER_FILTER_TRILINEAR;
+	else
+		return false;
+
+	return isDescriptionEnd(value);
+}
+
+// "horizontal vertical", like Label::setTextAlign
+static bool parseDescriptionAlign(const char* value, Align& horizontal, Align& vertical)
+{
+	Align* aligns[] = { &horizontal, &vertical };
+	for (Align* align : aligns)
+	{
+		int32_t index = 0;
+		while (index < static_cast<int32_t>(std::size(descriptionAlignNames)) && !readDescriptionWord(value, descriptionAlignNames[index]))
+			index++;
+
+		if (index == static_cast<int32_t>(std::size(descriptionAlignNames)))
+			return false;
+
+		*align = static_cast<Align>(index);
+	}
+
+	return isDescriptionEnd(value);
+}
+
+// A number is an index of Settings::addDefaultFont, anything else a file from the fonts folder
+static bool parseDescriptionFont(const char* value, UIDescription::Node& node)
+{
+	const char* cursor = value;
+	int32_t fontIndex = 0;
+	if (readDescriptionInts(cursor, &fontIndex, 1) && isDescriptionEnd(cursor))
+	{
+		node.defaultFont = fontIndex;
+		return fontIndex >= 0;
+	}
+
+	node.font = Settings::get().getFontId(value);
+	return *value != '\0';
+}
+
+bool UIDescription::load(const char* file)
+{
+	clear();
+
+	Unigine::XmlPtr xml = Unigine::Xml::create();
+	if (!xml->load(Settings::get().getPath(Settings::get().getLayoutId(file))))
+	{
+		Unigine::Log::error("noMoPi: can't load UI description \"%s\"\n", file);
+		return false;
+	}
+
+	return _build(xml, file);
+}
+
+bool UIDescription::parse(const char* source)
+{
+	clear();
+
+	Unigine::XmlPtr xml = Unigine::Xml::create();
+	if (!xml->parse(source))
+	{
+		Unigine::Log::error("noMoPi: can't parse UI description\n");
+		return false;
+	}
+
+	return _build(xml, "UI description");
+}
+
+void UIDescription::clear()
+{
+	_root = nullptr;
+	_ids.clear();
+	_strings.clear();
+	_parsedIds.clear();
+}
+
+bool UIDescription::parseNode(const Unigine::XmlPtr& xml, Node& node, const char* source)
+{
+	const char* element = xml->getName();
+
+	int32_t type = 0;
+	while (type < static_cast<int32_t>(std::size(descriptionElementNames)) && strcmp(element, descriptionElementNames[type]))
+		type++;
+
+	if (type == static_cast<int32_t>(std::size(descriptionElementNames)))
+	{
+		Unigine::Log::error("noMoPi: %s: unknown element <%s>\n", source, element);
+		return false;
+	}
+
+	node.type = static_cast<NodeType>(type);
+
+	const bool isBox = isContainer(node.type);
+	const bool isLabel = node.type == NodeType::Label;
+	const bool hasFont = isLabel || node.type == NodeType::EditLine;
+
+	for (int32_t i = 0; i < xml->getNumArgs(); i++)
+	{
+		const char* name = xml->getArgName(i);
+		const char* value = xml->getArgValue(i);
+
+		bool isValid = false;
+		if (!strcmp(name, "id"))
+		{
+			node.id = value;
+			isValid = *value != '\0';
+		}
+		else if (!strcmp(name, "scale"))
+			isValid = parseDescriptionScale(value, node.scaleSettings);
+		else if (isBox && !strcmp(name, "padding"))
+		{
+			node.fields |= FieldPadding;
+			isValid = parseDescriptionPadding(value, node.padding);
+		}
+		else if (isBox && !strcmp(name, "paddingEqual"))
+		{
+			node.fields |= FieldPaddingEqual;
+			isValid = parseDescriptionBool(value, node.isPaddingEqual);
+		}
+		else if (isBox && !strcmp(name, "spacing"))
+		{
+			node.fields |= FieldSpacing;
+			isValid = parseDescriptionFloat(value, node.spacing);
+		}
+		else if (isBox && !strcmp(name, "ignorePadding"))
+		{
+			node.fields |= FieldSpacing;
+			isValid = parseDescriptionBool(value, node.ignorePadding);
+		}
+		else if (isBox && !strcmp(name, "background"))
+		{
+			node.fields |= FieldBackground;
+			isValid = parseDescriptionBool(value, node.hasBackground);
+		}
+		else if (isBox && !strcmp(name, "backgroundColor"))
+		{
+			node.fields |= FieldBackgroundColor;
+			isValid = parseDescriptionColor(value, node.backgroundColor);
+		}
+		else if (isBox && !strcmp(name, "backgroundTexture"))
+		{
+			node.fields |= FieldBackgroundTexture;
+			node.backgroundTexture = Settings::get().getTextureId(value);
+			isValid = *value != '\0';
+		}
+		else if (isBox && !strcmp(name, "backgroundFiltering"))
+		{
+			node.fields |= FieldBackgroundFiltering;
+			isValid = parseDescriptionFiltering(value, node.backgroundFiltering);
+		}
+		else if (isBox && !strcmp(name, "nineSlice"))
+		{
+			node.fields |= FieldNineSlice;
+			int32_t borders[4] = {};
+			isValid = readDescriptionInts(value, borders, 4) && isDescriptionEnd(value);
+			node.nineSlice = Unigine::Math::ivec4(borders[0], borders[1], borders[2], borders[3]);
+		}
+		else if (node.type == NodeType::ScrollBox && !strcmp(name, "items"))
+		{
+			node.fields |= FieldItemCount;
+			isValid = readDescriptionInts(value, &node.itemCount, 1) && isDescriptionEnd(value);
+		}
+		else if (isLabel && !strcmp(name, "text"))
+		{
+			node.fields |= FieldText;
+			node.text = value;
+			isValid = true;
+		}
+		else if (isLabel && !strcmp(name, "translatable"))
+			isValid = parseDescriptionBool(value, node.isTranslatable);
+		else if (hasFont && !strcmp(name, "font"))
+		{
+			node.fields |= FieldFont;
+			isValid = parseDescriptionFont(value, node);
+		}
+		else if (isLabel && !strcmp(name, "fontSize"))
+		{
+			node.fields |= FieldFontSize;
+			isValid = parseDescriptionFloat(value, node.fontSize);
+		}
+		else if (isLabel && !strcmp(name, "fontWrap"))
+		{
+			node.fields |= FieldFontWrap;
+			isValid = parseDescriptionBool(value, node.fontWrap);
+		}
+		else if (isLabel && !strcmp(name, "fontMaxHSpacing"))
+		{
+			node.fields |= FieldFontMaxHSpacing;
+			isValid = parseDescriptionFloat(value, node.fontMaxHSpacing);
+		}
+		else if (isLabel && !strcmp(name, "fontMaxVSpacing"))
+		{
+			node.fields |= FieldFontMaxVSpacing;
+			isValid = parseDescriptionFloat(value, node.fontMaxVSpacing);
+		}
+		else if (isLabel && !strcmp(name, "fontHSpacing"))
+		{
+			node.fields |= FieldFontHSpacing;
+			isValid = parseDescriptionFloat(value, node.fontHSpacing);
+		}
+		else if (isLabel && !strcmp(name, "fontVSpacing"))
+		{
+			node.fields |= FieldFontVSpacing;
+			isValid = parseDescriptionFloat(value, node.fontVSpacing);
+		}
+		else if (isLabel && !strcmp(name, "align"))
+		{
+			node.fields |= FieldAlign;
+			isValid = parseDescriptionAlign(value, node.horizontalAlign, node.verticalAlign);
+		}
+		else if (node.type == NodeType::CheckBox && !strcmp(name, "checked"))
+		{
+			node.fields |= FieldChecked;
+			isValid = parseDescriptionBool(value, node.isChecked);
+		}
+
+		if (!isValid)
+		{
+			Unigine::Log::error("noMoPi: %s: unknown or invalid attribute %s=\"%s\" on <%s>\n", source, name, value, element);
+			return false;
+		}
+	}
+
+	if ((node.fields & FieldNineSlice) && !(node.fields & FieldBackgroundTexture))
+	{
+		Unigine::Log::error("noMoPi: %s: nineSlice on <%s> needs a backgroundTexture\n", source, element);
+		return false;
+	}
+
+	return true;
+}
+
+static void applyDescriptionContainer(WidgetContainer& container, const UIDescription::Node& node)
+{
+	if (node.fields & UIDescription::FieldBackground)
+		container.setBackgroundEnabled(node.hasBackground);
+
+	if (node.fields & UIDescription::FieldNineSlice)
+		container.setBackgroundNineSlice(node.backgroundTexture, node.nineSlice.x, node.nineSlice.y, node.nineSlice.z, node.nineSlice.w);
+	else if (node.fields & UIDescription::FieldBackgroundTexture)
+		container.setBackgroundTexture(node.backgroundTexture);
+
+	if (node.fields & UIDescription::FieldBackgroundFiltering)
+		container.setBackgroundTextureFiltering(node.backgroundFiltering);
+	if (node.fields & UIDescription::FieldBackgroundColor)
+		container.setBackgroundColor(node.backgroundColor.x, node.backgroundColor.y, node.backgroundColor.z, node.backgroundColor.w);
+	if (node.fields & UIDescription::FieldPadding)
+		container.setPadding(node.padding.x, node.padding.y, node.padding.z, node.padding.w);
+	if (node.fields & UIDescription::FieldPaddingEqual)
+		container.setPaddingEqual(node.isPaddingEqual);
+	if (node.fields & UIDescription::FieldSpacing)
+		container.setSpacing(node.spacing, node.ignorePadding);
+}
+
+static ResourceId getDescriptionFont(const UIDescription::Node& node)
+{
+	if (node.defaultFont < 0)
+		return node.font;
+
+	if (node.defaultFont < Settings::get().getDefaultFontCount())
+		return Settings::get().getDefaultFontId(node.defaultFont);
+
+	Unigine::Log::error("noMoPi: UI description uses default font %d, but only %d are added\n", node.defaultFont, Settings::get().getDefaultFontCount());
+	return InvalidResource;
+}
+
+static void applyDescriptionLabel(Label& label, const UIDescription::Node& node)
+{
+	if (node.fields & UIDescription::FieldText)
+		label.setText(node.text, node.isTranslatable);
+	if (node.fields & UIDescription::FieldFontSize)
+		label.setFontSize(node.fontSize);
+	if (node.fields & UIDescription::FieldFontWrap)
+		label.setFontWrap(node.fontWrap);
+	if (node.fields & UIDescription::FieldFontMaxHSpacing)
+		label.setFontMaxHSpacing(node.fontMaxHSpacing);
+	if (node.fields & UIDescription::FieldFontMaxVSpacing)
+		label.setFontMaxVSpacing(node.fontMaxVSpacing);
+	if (node.fields & UIDescription::FieldFontHSpacing)
+		label.setFontHSpacing(node.fontHSpacing);
+	if (node.fields & UIDescription::FieldFontVSpacing)
+		label.setFontVSpacing(node.fontVSpacing);
+	if (node.fields & UIDescription::FieldFont)
+	{
+		const ResourceId font = getDescriptionFont(node);
+		if (font != InvalidResource)
+			label.setFont(font);
+	}
+
+	if (node.fields & UIDescription::FieldAlign)
+		label.setTextAlign(node.horizontalAlign, node.verticalAlign);
+}
+
+std::shared_ptr<WidgetBase> UIDescription::createWidget(const Node& node)
+{
+	switch (node.type)
+	{
+	case NodeType::HBox:
+	{
+		auto hbox = HBox::create(node.scaleSettings);
+		applyDescriptionContainer(*hbox, node);
+		return hbox;
+	}
+	case NodeType::VBox:
+	{
+		auto vbox = VBox::create(node.scaleSettings);
+		applyDescriptionContainer(*vbox, node);
+		return vbox;
+	}
+	case NodeType::ScrollBox:
+	{
+		auto scrollBox = ScrollBox::create(node.scaleSettings);
+		applyDescriptionContainer(*scrollBox, node);
+		if (node.fields & FieldItemCount)
+			scrollBox->setVisibleItemCount(node.itemCount);
+
+		return scrollBox;
+	}
+	case NodeType::Label:
+	{
+		auto label = Label::create(node.scaleSettings);
+		applyDescriptionLabel(*label, node);
+		return label;
+	}
+	case NodeType::EditLine:
+	{
+		auto edit = EditLine::create(node.scaleSettings);
+		const ResourceId font = (node.fields & FieldFont) ? getDescriptionFont(node) : InvalidResource;
+		if (font != InvalidResource)
+			edit->setFont(font);
+
+		return edit;
+	}
+	case NodeType::CheckBox:
+	{
+		auto check = CheckBox::create(node.scaleSettings);
+		if (node.fields & FieldChecked)
+			check->setChecked(node.isChecked);
+
+		return check;
+	}
+	}
+
+	return nullptr;
+}
+
+// Parses the elements depth first and hands every node with the index of its parent to visit
+template<typename Visitor>
+static bool visitDescriptionNodes(const Unigine::XmlPtr& xml, const char* source, Visitor&& visit)
+{
+	struct Element
+	{
+		Unigine::XmlPtr xml;
+		int32_t parent = -1;
+	};
+
+	std::vector<Element> stack;
+	stack.push_back({ xml, -1 });
+
+	UIDescription::Node node;
+	int32_t index = 0;
+	while (!stack.empty())
+	{
+		Element element = std::move(stack.back());
+		stack.pop_back();
+
+		node = UIDescription::Node();
+		if (!UIDescription::parseNode(element.xml, node, source))
+			return false;
+
+		const int32_t childCount = element.xml->getNumChildren();
+		if (childCount && !UIDescription::isContainer(node.type))
+		{
+			Unigine::Log::error("noMoPi: %s: <%s> can't have children\n", source, element.xml->getName());
+			return false;
+		}
+
+		if (!visit(node, element.parent))
+			return false;
+
+		for (int32_t i = childCount - 1; i >= 0; i--)
+			stack.push_back({ element.xml->getChild(i), index });
+
+		index++;
+	}
+
+	return true;
+}
+
+bool UIDescription::_build(const Unigine::XmlPtr& xml, const char* source)
+{
+	std::vector<WidgetBase*> widgets;
+	const bool isBuilt = visitDescriptionNodes(xml, source, [&](const Node& node, int32_t parent) {
+		const char* id = node.id ? _parsedIds.emplace_back(node.id).get() : nullptr;
+		widgets.push_back(_addWidget(node, id, parent >= 0 ? widgets[parent] : nullptr, source));
+		return widgets.back() != nullptr;
+	});
+
+	if (!isBuilt)
+		clear();
+
+	return isBuilt;
+}
+
+WidgetBase* UIDescription::_addWidget(const Node& node, const char* id, WidgetBase* parent, const char* source)
+{
+	std::shared_ptr<WidgetBase> widget = createWidget(node);
+	if (!widget)
+	{
+		Unigine::Log::error("noMoPi: %s: unknown widget type %d\n", source, static_cast<int32_t>(node.type));
+		return nullptr;
+	}
+
+	if (id)
+	{
+		if (_ids.find(id) != _ids.end())
+		{
+			Unigine::Log::error("noMoPi: %s: duplicate id \"%s\"\n", source, id);
+			return nullptr;
+		}
+
+		_ids.append(std::string_view(id), widget);
+	}
+
+	if (parent)
+		parent->addChild(widget);
+	else
+		_root = widget;
+
+	return widget.get();
+}
+
+bool UIDescription::compile(const char* sourcePath, const char* outputPath)
+{
+	Unigine::XmlPtr xml = Unigine::Xml::create();
+	if (!xml->load(sourcePath))
+	{
+		Unigine::Log::error("noMoPi: can't load UI description \"%s\"\n", sourcePath);
+		return false;
+	}
+
+	std::vector<uint8_t> blob;
+	if (!compile(xml, sourcePath, blob))
+		return false;
+
+	FILE* file = fopen(outputPath, "wb");
+	const bool isWritten = file && fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+	if (file)
+		fclose(file);
+
+	if (!isWritten)
+	{
+		Unigine::Log::error("noMoPi: can't save compiled UI description to \"%s\"\n", outputPath);
+		return false;
+	}
+
+	return true;
+}
+
+bool UIDescription::compile(const Unigine::XmlPtr& xml, const char* source, std::vector<uint8_t>& blob)
+{
+	std::vector<CompiledNode> nodes;
+	std::vector<uint32_t> resources;
+	std::vector<char> strings;
+	Unigine::HashMap<Unigine::String, uint32_t> stringOffsets;
+	Unigine::HashMap<ResourceId, int32_t> resourceIndices;
+
+	// equal strings are stored once, every one is null terminated so the runtime can point into the blob
+	auto addString = [&](const char* string) {
+		auto it = stringOffsets.find(string);
+		if (it != stringOffsets.end())
+			return it->data;
+
+		const uint32_t offset = static_cast<uint32_t>(strings.size());
+		strings.insert(strings.end(), string, string + strlen(string) + 1);
+		stringOffsets.append(Unigine::String(string), offset);
+		return offset;
+	};
+
+	auto addResource = [&](ResourceId resource) {
+		if (resource == InvalidResource)
+			return -1;
+
+		auto it = resourceIndices.find(resource);
+		if (it != resourceIndices.end())
+			return it->data;
+
+		const int32_t index = static_cast<int32_t>(resources.size());
+		resources.push_back(addString(Settings::get().getPath(resource)));
+		resourceIndices.append(resource, index);
+		return index;
+	};
+
+	const bool isParsed = visitDescriptionNodes(xml, source, [&](const Node& node, int32_t parent) {
+		CompiledNode& compiled = nodes.emplace_back();
+		compiled.type = static_cast<uint8_t>(node.type);
+		compiled.scaleType = static_cast<uint8_t>(node.scaleSettings.scaleType);
+		compiled.horizontalAlign = static_cast<uint8_t>(node.horizontalAlign);
+		compiled.verticalAlign = static_cast<uint8_t>(node.verticalAlign);
+		compiled.fields = node.fields;
+		compiled.parent = parent;
+		compiled.id = node.id ? addString(node.id) : _noString;
+		compiled.text = node.text ? addString(node.text) : _noString;
+		compiled.backgroundTexture = addResource(node.backgroundTexture);
+		compiled.font = addResource(node.font);
+		compiled.defaultFont = node.defaultFont;
+		compiled.backgroundFiltering = node.backgroundFiltering;
+		compiled.itemCount = node.itemCount;
+		compiled.scaleFactor = node.scaleSettings.scaleFactor;
+		compiled.spacing = node.spacing;
+		compiled.fontSize = node.fontSize;
+		compiled.fontMaxHSpacing = node.fontMaxHSpacing;
+		compiled.fontMaxVSpacing = node.fontMaxVSpacing;
+		compiled.fontHSpacing = node.fontHSpacing;
+		compiled.fontVSpacing = node.fontVSpacing;
+
+		for (int32_t i = 0; i < 4; i++)
+		{
+			compiled.padding[i] = node.padding[i];
+			compiled.backgroundColor[i] = node.backgroundColor[i];
+			compiled.nineSlice[i] = node.nineSlice[i];
+		}
+
+		compiled.isPaddingEqual = node.isPaddingEqual;
+		compiled.ignorePadding = node.ignorePadding;
+		compiled.hasBackground = node.hasBackground;
+		compiled.isTranslatable = node.isTranslatable;
+		compiled.fontWrap = node.fontWrap;
+		compiled.isChecked = node.isChecked;
+		return true;
+	});
+
+	if (!isParsed)
+		return false;
+
+	CompiledHeader header;
+	header.nodeCount = static_cast<uint32_t>(nodes.size());
+	header.resourceCount = static_cast<uint32_t>(resources.size());
+	header.stringsSize = static_cast<uint32_t>(strings.size());
+
+	blob.resize(sizeof(CompiledHeader) + nodes.size() * sizeof(CompiledNode) + resources.size() * sizeof(uint32_t) + strings.size());
+	uint8_t* tables = blob.data() + sizeof(CompiledHeader);
+	memcpy(tables, nodes.data(), nodes.size() * sizeof(CompiledNode));
+	memcpy(tables + nodes.size() * sizeof(CompiledNode), resources.data(), resources.size() * sizeof(uint32_t));
+	memcpy(tables + nodes.size() * sizeof(CompiledNode) + resources.size() * sizeof(uint32_t), strings.data(), strings.size());
+
+	header.checksum = Unigine::CRC32::calcCrc32(tables, blob.size() - sizeof(CompiledHeader));
+	memcpy(blob.data(), &header, sizeof(CompiledHeader));
+
+	return true;
+}
+
+bool UIDescription::loadCompiled(const char* file)
+{
+	clear();
+
+	const Unigine::String& path = Settings::get().getPath(Settings::get().getLayoutId(file));
+	MappedFile mapped;
+	if (!mapped.open(Unigine::FileSystem::getAbsolutePath(path)))
+	{
+		Unigine::Log::error("noMoPi: can't load compiled UI description \"%s\"\n", file);
+		return false;
+	}
+
+	return instantiate(mapped.getData(), mapped.getSize(), file);
+}
+
+bool UIDescription::instantiate(const uint8_t* data, size_t size, const char* source)
+{
+	clear();
+
+	CompiledHeader header;
+	if (size >= sizeof(CompiledHeader))
+		memcpy(&header, data, sizeof(CompiledHeader));
+
+	if (size < sizeof(CompiledHeader) || header.magic != _compiledMagic)
+	{
+		Unigine::Log::error("noMoPi: %s: not a compiled UI description\n", source);
+		return false;
+	}
+
+	if (header.version != _compiledVersion)
+	{
+		Unigine::Log::error("noMoPi: %s: version %u isn't supported, compile it again for version %u\n", source, header.version, _compiledVersion);
+		return false;
+	}
+
+	const uint64_t tablesSize = static_cast<uint64_t>(header.nodeCount) * sizeof(CompiledNode) + static_cast<uint64_t>(header.resourceCount) * sizeof(uint32_t) + header.stringsSize;
+	const uint8_t* tables = data + sizeof(CompiledHeader);
+	if (tablesSize != size - sizeof(CompiledHeader) || Unigine::CRC32::calcCrc32(tables, size - sizeof(CompiledHeader)) != header.checksum)
+	{
+		Unigine::Log::error("noMoPi: %s: damaged, the checksum doesn't match\n", source);
+		return false;
+	}
+
+	const uint8_t* nodes = tables;
+	const uint8_t* resourceOffsets = nodes + header.nodeCount * sizeof(CompiledNode);
+
+	const char* blobStrings = reinterpret_cast<const char*>(resourceOffsets + header.resourceCount * sizeof(uint32_t));
+	_strings.assign(blobStrings, blobStrings + header.stringsSize);
+	const char* strings = _strings.data();
+
+	auto getString = [&](uint32_t offset) -> const char* {
+		if (offset == _noString)
+			return nullptr;
+
+		return offset < header.stringsSize && !strings[header.stringsSize - 1] ? strings + offset : "";
+	};
+
+	std::vector<ResourceId> resources(header.resourceCount);
+	for (uint32_t i = 0; i < header.resourceCount; i++)
+	{
+		uint32_t offset = 0;
+		memcpy(&offset, resourceOffsets + i * sizeof(uint32_t), sizeof(uint32_t));
+
+		const char* path = getString(offset);
+		resources[i] = path && *path ? Settings::get().getResourceId(path) : InvalidResource;
+	}
+
+	auto getResource = [&](int32_t index) {
+		return index >= 0 && index < static_cast<int32_t>(resources.size()) ? resources[index] : InvalidResource;
+	};
+
+	std::vector<WidgetBase*> widgets(header.nodeCount);
+	CompiledNode compiled;
+	Node node;
+	for (uint32_t i = 0; i < header.nodeCount; i++)
+	{
+		memcpy(&compiled, nodes + i * sizeof(CompiledNode), sizeof(CompiledNode));
+
+		if ((i == 0) != (compiled.parent < 0) || compiled.parent >= static_cast<int32_t>(i))
+		{
+			Unigine::Log::error("noMoPi: %s: node %u has an invalid parent\n", source, i);
+			clear();
+			return false;
+		}
+
+		if (compiled.type > std::to_underlying(NodeType::CheckBox) || compiled.scaleType > std::to_underlying(ScaleType::PixelPerfect) ||
+			compiled.horizontalAlign > std::to_underlying(Align::Center) || compiled.verticalAlign > std::to_underlying(Align::Center))
+		{
+			Unigine::Log::error("noMoPi: %s: node %u has an invalid type, scale type or alignment\n", source, i);
+			clear();
+			return false;
+		}
+
+		node.type = static_cast<NodeType>(compiled.type);
+		node.fields = compiled.fields;
+		node.scaleSettings.scaleType = static_cast<ScaleType>(compiled.scaleType);
+		node.scaleSettings.scaleFactor = compiled.scaleFactor;
+		node.id = getString(compiled.id);
+		node.padding = Unigine::Math::vec4(compiled.padding[0], compiled.padding[1], compiled.padding[2], compiled.padding[3]);
+		node.isPaddingEqual = compiled.isPaddingEqual;
+		node.spacing = compiled.spacing;
+		node.ignorePadding = compiled.ignorePadding;
+		node.hasBackground = compiled.hasBackground;
+		node.backgroundColor = Unigine::Math::ivec4(compiled.backgroundColor[0], compiled.backgroundColor[1], compiled.backgroundColor[2], compiled.backgroundColor[3]);
+		node.backgroundTexture = getResource(compiled.backgroundTexture);
+		node.backgroundFiltering = compiled.backgroundFiltering;
+		node.nineSlice = Unigine::Math::ivec4(compiled.nineSlice[0], compiled.nineSlice[1], compiled.nineSlice[2], compiled.nineSlice[3]);
+		node.itemCount = compiled.itemCount;
+		node.text = getString(compiled.text);
+		node.isTranslatable = compiled.isTranslatable;
+		node.defaultFont = compiled.defaultFont;
+		node.font = getResource(compiled.font);
+		node.fontSize = compiled.fontSize;
+		node.fontWrap = compiled.fontWrap;
+		node.fontMaxHSpacing = compiled.fontMaxHSpacing;
+		node.fontMaxVSpacing = compiled.fontMaxVSpacing;
+		node.fontHSpacing = compiled.fontHSpacing;
+		node.fontVSpacing = compiled.fontVSpacing;
+		node.horizontalAlign = static_cast<Align>(compiled.horizontalAlign);
+		node.verticalAlign = static_cast<Align>(compiled.verticalAlign);
+		node.isChecked = compiled.isChecked;
+
+		widgets[i] = _addWidget(node, node.id, i ? widgets[compiled.parent] : nullptr, source);
+		if (!widgets[i])
+		{
+			clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size = {};
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	// the mapping keeps the file open
+	CloseHandle(file);
+	if (!_mapping)
+		return false;
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!_data)
+	{
+		close();
+		return false;
+	}
+
+	_size = static_cast<size_t>(size.QuadPart);
+#else
+	const int file = ::open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat status = {};
+	void* data = MAP_FAILED;
+	if (!fstat(file, &status) && status.st_size > 0)
+		data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	::close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	_data = static_cast<const uint8_t*>(data);
+	_size = static_cast<size_t>(status.st_size);
+#endif
+
+	return true;
 }
 
-void noMoPi::Interactive::attach(const std::shared_ptr<WidgetBase>& widget)
+void MappedFile::close()
 {
-	widget->getWidget()->addChild(_interactiveLayer, Unigine::Gui::ALIGN_OVERLAP | Unigine::Gui::ALIGN_FIXED);
+#ifdef _WIN32
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+#else
+	if (_data)
+		munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
 }
@@ -2,11 +2,176 @@
 
 #include <UnigineGui.h>
 #include <UnigineWidgets.h>
+#include <UnigineHashMap.h>
+#include <UnigineTextures.h>
+#include <UnigineImage.h>
+#include <UnigineHashSet.h>
+#include <UnigineXml.h>
 #include <vector>
+#include <deque>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <typeinfo>
+
+namespace Unigine
+{
+	// HashMap<std::string_view> lookups by plain strings, as with String keys
+	template<>
+	struct Hasher<std::string_view>
+	{
+		using HashType = unsigned int;
+		UNIGINE_INLINE static HashType create(const char* v) { return String::hash(v); }
+		UNIGINE_INLINE static HashType create(std::string_view v) { return String::hash(v.data(), static_cast<int>(v.size())); }
+	};
+}
 
 namespace noMoPi
 {
+	// Index of an interned resource path, see Settings::getPath
+	using ResourceId = int32_t;
+	constexpr ResourceId InvalidResource = -1;
+
+
+	// Per-screen memory, everything created inside an ArenaScope goes back to the heap at once with the arena.
+	// The arena has to outlive every widget allocated from it.
+	class Arena : public std::pmr::memory_resource
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t allocationCount = 0;
+			uint32_t deallocationCount = 0;
+			size_t bytes = 0;
+			// the only allocations that reach the heap
+			uint32_t chunkCount = 0;
+			size_t chunkBytes = 0;
+		};
+
+		explicit Arena(size_t initialSize = 64 * 1024);
+		virtual ~Arena();
+
+		const Statistics& getStatistics() const { return _statistics; }
+		uint32_t getLiveAllocationCount() const { return _statistics.allocationCount - _statistics.deallocationCount; }
+
+		// resource of the innermost ArenaScope, the default heap resource outside of one
+		static std::pmr::memory_resource* getCurrentResource();
+	private:
+		friend class ArenaScope;
+
+		class Upstream : public std::pmr::memory_resource
+		{
+		public:
+			Upstream(Statistics& statistics) : _statistics(statistics) {}
+		private:
+			void* do_allocate(size_t bytes, size_t alignment) override;
+			void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+			Statistics& _statistics;
+		};
+
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		static Arena*& _current();
+
+		Statistics _statistics;
+		Upstream _upstream;
+		std::pmr::monotonic_buffer_resource _buffer;
+	};
+
+
+	class ArenaScope
+	{
+	public:
+		explicit ArenaScope(Arena& arena) : _previous(Arena::_current()) { Arena::_current() = &arena; }
+		~ArenaScope() { Arena::_current() = _previous; }
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+	private:
+		Arena* _previous = nullptr;
+	};
+
+
+	class WidgetBase;
+	class Interactive;
+	struct ScaleSettings;
+
+	// Keeps released widgets by type so rebuilt screens reuse them, arena allocated widgets are rejected
+	class WidgetRecycler
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t reuseCount = 0;
+			uint32_t createCount = 0;
+			uint32_t pooledCount = 0;
+			uint32_t trimmedCount = 0;
+		};
+
+		static WidgetRecycler& get()
+		{
+			static WidgetRecycler instance;
+			return instance;
+		}
+
+		void setEnabled(bool isEnabled) { _isEnabled = isEnabled; }
+		bool isEnabled() const { return _isEnabled; }
+		void setMaxPerType(uint32_t count) { _maxPerType = count; }
+		void setMaxIdleTime(double seconds) { _maxIdleTime = seconds; }
+
+		template<typename T>
+		std::shared_ptr<T> acquire(const ScaleSettings& scaleSettings) { return std::static_pointer_cast<T>(_acquire(typeid(T), scaleSettings)); }
+		// Takes the last pointer to the widget, move it in. Types without reset support are dropped.
+		void release(std::shared_ptr<WidgetBase> widget);
+
+		// Drops widgets idle for longer than the max idle time
+		void update();
+		void trim(uint32_t maxPerType = 0);
+		// Drops every pooled widget, call before engine shutdown
+		void clear();
+
+		const Statistics& getStatistics() const { return _statistics; }
+	private:
+		WidgetRecycler();
+
+		struct Entry
+		{
+			std::shared_ptr<WidgetBase> widget;
+			long long releaseTime = 0;
+		};
+
+		std::shared_ptr<WidgetBase> _acquire(const std::type_info& type, const ScaleSettings& scaleSettings);
+
+		// released last at the back, oldest at the front
+		Unigine::HashMap<const std::type_info*, std::deque<Entry>> _pools;
+		bool _isEnabled = false;
+		uint32_t _maxPerType = 64;
+		double _maxIdleTime = 60.0;
+		Statistics _statistics;
+	};
+
+
+	// Allocates from the current ArenaScope, or reuses a released widget while recycling is on
+	template<typename T>
+	std::shared_ptr<T> makeWidget(const ScaleSettings& scaleSettings)
+	{
+		if (WidgetRecycler::get().isEnabled() && Arena::getCurrentResource() == std::pmr::get_default_resource())
+		{
+			if (std::shared_ptr<T> widget = WidgetRecycler::get().acquire<T>(scaleSettings))
+				return widget;
+		}
+
+		std::shared_ptr<T> widget = std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(Arena::getCurrentResource()), scaleSettings);
+		widget->_isInteractive = std::is_base_of_v<Interactive, T>;
+		widget->_containsInteractive = widget->_isInteractive;
+		return widget;
+	}
+
+
 	class Settings
 	{
 	public:
@@ -16,23 +181,270 @@ namespace noMoPi
 			return instance;
 		}
 
-		Unigine::String getLocalizationPath(const Unigine::String& file) const;
-		Unigine::String getFontsPath(const Unigine::String& font) const;
-		Unigine::String getTexturesPath(const Unigine::String& texture) const;
-		Unigine::String getWhiteBackground() const;
+		const Unigine::String& getLocalizationPath(const char* file) { return getPath(getLocalizationId(file)); }
+		const Unigine::String& getFontsPath(const char* font) { return getPath(getFontId(font)); }
+		const Unigine::String& getTexturesPath(const char* texture) { return getPath(getTextureId(texture)); }
+		const Unigine::String& getWhiteBackground() const { return getPath(_whiteBackgroundId); }
+		ResourceId getWhiteBackgroundId() const { return _whiteBackgroundId; }
+
+		// Interned, later lookups don't allocate and returned paths stay valid
+		ResourceId getTextureId(const char* texture);
+		ResourceId getFontId(const char* font);
+		ResourceId getLocalizationId(const char* file);
+		ResourceId getLayoutId(const char* file);
+		ResourceId getResourceId(const char* path);
+		const Unigine::String& getPath(ResourceId id) const { return _paths[id]; }
 
 		int32_t addDefaultFont(const char* font);
-		Unigine::String getDefaultFont(int32_t fontIndex);
+		const Unigine::String& getDefaultFont(int32_t fontIndex) const { return getPath(_defaultFonts[fontIndex]); }
+		ResourceId getDefaultFontId(int32_t fontIndex) const { return _defaultFonts[fontIndex]; }
+		int32_t getDefaultFontCount() const { return static_cast<int32_t>(_defaultFonts.size()); }
+
+		// Gui height textures are authored for, pixel sized elements like nine-slice borders scale from it
+		void setReferenceHeight(int32_t height) { _referenceHeight = height; }
+		int32_t getReferenceHeight() const { return _referenceHeight; }
+		float getScale(int32_t guiHeight) const { return static_cast<float>(guiHeight) / _referenceHeight; }
 	private:
-		Settings() = default;
+		Settings();
+
+		ResourceId _intern(Unigine::HashMap<Unigine::String, ResourceId>& ids, const Unigine::String& folder, const char* name);
+
 		const Unigine::String _rootFolder = ".noMorePixels/";
 		const Unigine::String _texturesFolder = "textures/";
 		const Unigine::String _localizationFolder = "localization/";
 		const Unigine::String _fontsFolder = "fonts/";
+		const Unigine::String _layoutsFolder = "layouts/";
 
-		std::vector<Unigine::String> _defaultFonts;
+		std::deque<Unigine::String> _paths;
+		Unigine::HashMap<Unigine::String, ResourceId> _textureIds;
+		Unigine::HashMap<Unigine::String, ResourceId> _fontIds;
+		Unigine::HashMap<Unigine::String, ResourceId> _localizationIds;
+		Unigine::HashMap<Unigine::String, ResourceId> _layoutIds;
+		Unigine::HashMap<Unigine::String, ResourceId> _pathIds;
+
+		std::vector<ResourceId> _defaultFonts;
+		int32_t _referenceHeight = 1080;
 
 		const Unigine::String _whiteBackground = "white.png";
+		ResourceId _whiteBackgroundId = InvalidResource;
+	};
+
+
+	class WidgetBase;
+
+	// Refcounted textures shared by all widgets, keyed by the resolved texture path
+	class TextureCache
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t hits = 0;
+			uint32_t misses = 0;
+			// first acquires of preloaded textures, counted apart from hits
+			uint32_t preloadHits = 0;
+			uint32_t expiredCount = 0;
+			uint32_t textureCount = 0;
+			uint32_t pendingCount = 0;
+			size_t bytes = 0;
+		};
+
+		static TextureCache& get()
+		{
+			static TextureCache instance;
+			return instance;
+		}
+
+		Unigine::TexturePtr acquire(ResourceId texture);
+		Unigine::TexturePtr acquire(const Unigine::String& path) { return acquire(Settings::get().getResourceId(path)); }
+		void release(ResourceId texture);
+		void release(const Unigine::String& path) { release(Settings::get().getResourceId(path)); }
+
+		// Loads on the engine loader threads, widgets show a white placeholder until update() swaps the image in.
+		// A preload nothing acquires within the max preload time is dropped.
+		void preload(const std::vector<ResourceId>& textures);
+		void preload(const std::vector<Unigine::String>& paths);
+		void setMaxPreloadTime(double seconds) { _maxPreloadTime = seconds; }
+		// Textures a built tree uses, to save and preload before building it the next time
+		static std::vector<ResourceId> collectTextures(const std::shared_ptr<WidgetBase>& widget);
+		void update();
+		bool isLoading() const { return _statistics.pendingCount > 0; }
+		void setAsyncLoading(bool isAsyncLoading) { _isAsyncLoading = isAsyncLoading; }
+		// Drops every texture and the placeholder, call before engine shutdown
+		void clear();
+
+		const Statistics& getStatistics() const { return _statistics; }
+		void resetStatistics();
+		size_t getBytes(ResourceId texture) const;
+	private:
+		TextureCache() = default;
+
+		struct Entry
+		{
+			Unigine::TexturePtr texture;
+			int32_t references = 0;
+			size_t bytes = 0;
+			int32_t asyncId = -1;
+			long long preloadTime = 0;
+		};
+
+		Entry& _createEntry(ResourceId texture, bool isAsync);
+		void _preload(ResourceId texture);
+		Unigine::HashMap<ResourceId, Entry>::Iterator _erase(Unigine::HashMap<ResourceId, Entry>::Iterator it);
+		const Unigine::ImagePtr& _getPlaceholder();
+
+		Unigine::HashMap<ResourceId, Entry> _textures;
+		Unigine::ImagePtr _placeholder;
+		Statistics _statistics;
+		bool _isAsyncLoading = false;
+		double _maxPreloadTime = 60.0;
+		uint32_t _preloadedCount = 0;
+	};
+
+
+	// Packs small UI textures into one texture so widgets drawing them don't switch textures
+	class TextureAtlas
+	{
+	public:
+		struct Region
+		{
+			// x, y, width, height in atlas pixels
+			Unigine::Math::ivec4 rect;
+			// x0, y0, x1, y1 in normalized atlas coordinates
+			Unigine::Math::vec4 texCoord;
+		};
+
+		static TextureAtlas& get()
+		{
+			static TextureAtlas instance;
+			return instance;
+		}
+
+		bool build(const std::vector<Unigine::String>& textures, int32_t maxSize = 2048, int32_t padding = 1);
+		// Packs images that are already loaded and converted to RGBA8, textures names their regions
+		bool build(const std::vector<Unigine::String>& textures, const std::vector<Unigine::ImagePtr>& images, int32_t maxSize = 2048, int32_t padding = 1);
+		void clear();
+		// Checks coordinates, padding extrusion and packing, and pixels against the sources when they load
+		bool validate() const;
+
+		bool contains(const Unigine::String& texture) const { return _regions.contains(texture); }
+		const Region& getRegion(const Unigine::String& texture) const { return _regions[texture]; }
+		const Unigine::TexturePtr& getTexture() const { return _texture; }
+		const Unigine::ImagePtr& getImage() const { return _image; }
+		Unigine::Math::ivec2 getSize() const { return _size; }
+
+		// Shelf packing without the engine, so it can be checked offline
+		static bool pack(const std::vector<Unigine::Math::ivec2>& sizes, int32_t maxSize, int32_t padding,
+			std::vector<Unigine::Math::ivec4>& rects, Unigine::Math::ivec2& atlasSize);
+		static bool validatePacking(const std::vector<Unigine::Math::ivec4>& rects, const Unigine::Math::ivec2& atlasSize, int32_t padding);
+	private:
+		TextureAtlas() = default;
+
+		Unigine::HashMap<Unigine::String, Region> _regions;
+		Unigine::ImagePtr _image;
+		Unigine::TexturePtr _texture;
+		Unigine::Math::ivec2 _size;
+		int32_t _padding = 0;
+	};
+
+
+	// Rasterizes glyphs for the font sizes a layout uses so the first frame after a resize or language switch doesn't hitch
+	class GlyphWarmup
+	{
+	public:
+		struct Report
+		{
+			int32_t glyphCount = 0;
+			int32_t fontSizeCount = 0;
+			double milliseconds = 0.0;
+		};
+
+		void addText(ResourceId font, int32_t fontSize, const char* text);
+		void addLayout(const std::shared_ptr<WidgetBase>& widget);
+		bool addDictionary(const char* dictionary, const char* language, ResourceId font, const std::vector<int32_t>& fontSizes);
+
+		Report warm();
+		void clear();
+	private:
+		struct Batch
+		{
+			ResourceId font = InvalidResource;
+			int32_t fontSize = 0;
+			Unigine::HashSet<unsigned int> codes;
+		};
+
+		Batch& _getBatch(ResourceId font, int32_t fontSize);
+
+		std::vector<Batch> _batches;
+		Unigine::HashMap<Unigine::Math::ivec2, int32_t> _batchIndices;
+	};
+
+
+	// Snaps computed font sizes to a fixed set so resizing doesn't create a glyph cache entry for every pixel size
+	class FontSizePolicy
+	{
+	public:
+		enum class Mode
+		{
+			Exact,
+			Ladder,
+			Buckets
+		};
+
+		struct Statistics
+		{
+			uint32_t liveSizeCount = 0;
+			uint32_t peakSizeCount = 0;
+		};
+
+		static FontSizePolicy& get()
+		{
+			static FontSizePolicy instance;
+			return instance;
+		}
+
+		FontSizePolicy* setExact();
+		// sizes minSize, minSize * ratio, minSize * ratio^2...
+		FontSizePolicy* setLadder(float ratio, int32_t minSize = 8, int32_t maxSize = 1024);
+		// count sizes evenly spread from minSize to maxSize
+		FontSizePolicy* setBuckets(int32_t count, int32_t minSize = 8, int32_t maxSize = 256);
+
+		Mode getMode() const { return _mode; }
+
+		// largest allowed size not above the requested one, so quantized text still fits
+		int32_t quantize(int32_t fontSize) const;
+
+		void acquire(ResourceId font, int32_t fontSize);
+		void release(ResourceId font, int32_t fontSize);
+
+		uint32_t getLiveSizeCount(ResourceId font) const;
+		const Statistics& getStatistics() const { return _statistics; }
+		void resetPeak() { _statistics.peakSizeCount = _statistics.liveSizeCount; }
+	private:
+		friend class LayoutTrace;
+
+		FontSizePolicy() = default;
+
+		Mode _mode = Mode::Exact;
+		std::vector<int32_t> _sizes;
+
+		Unigine::HashMap<Unigine::Math::ivec2, uint32_t> _liveSizes;
+		Statistics _statistics;
+	};
+
+
+	// The font size a widget currently renders with, counted in FontSizePolicy while alive
+	class FontSizeUsage
+	{
+	public:
+		FontSizeUsage() = default;
+		FontSizeUsage(const FontSizeUsage&) = delete;
+		FontSizeUsage& operator=(const FontSizeUsage&) = delete;
+		~FontSizeUsage() { set(InvalidResource, 0); }
+
+		void set(ResourceId font, int32_t fontSize);
+	private:
+		ResourceId _font = InvalidResource;
+		int32_t _fontSize = 0;
 	};
 
 
@@ -61,10 +473,163 @@ namespace noMoPi
 	};
 
 
-	class WidgetBase
+	// Bounding volume hierarchy over sibling layout rects
+	class SpatialIndex
+	{
+	public:
+		struct RayHit
+		{
+			int32_t index = -1;
+			float distance = 0.f;
+		};
+
+		// rects are x, y, width, height
+		void build(const std::vector<Unigine::Math::ivec4>& rects);
+		// Updates the bounds for moved rects and keeps the tree, rects must be as many as the index was built with
+		void refit(const std::vector<Unigine::Math::ivec4>& rects);
+		void clear();
+		bool isEmpty() const { return _nodes.empty(); }
+		size_t getCount() const { return _bounds.size(); }
+		size_t getBytes() const { return _nodes.capacity() * sizeof(Node) + _indices.capacity() * sizeof(int32_t) + _bounds.capacity() * sizeof(Unigine::Math::ivec4); }
+
+		void queryPoint(int32_t x, int32_t y, std::vector<int32_t>& indices) const;
+		void queryRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<RayHit>& hits) const;
+
+		// bounds are x0, y0, x1, y1; a zero direction component gives an infinite inverse, handled as a ray parallel to that axis
+		static bool intersectRay(const Unigine::Math::ivec4& bounds, const Unigine::Math::vec2& origin, const Unigine::Math::vec2& inverseDirection, float& distance);
+	private:
+		struct Node
+		{
+			// min x, min y, max x, max y
+			Unigine::Math::ivec4 bounds;
+			int32_t first = 0;
+			// zero for inner nodes, their left child follows them and right points to the other one
+			int32_t count = 0;
+			int32_t right = 0;
+		};
+
+		int32_t _build(int32_t first, int32_t count);
+
+		static constexpr int32_t _leafSize = 4;
+
+		std::vector<Node> _nodes;
+		std::vector<int32_t> _indices;
+		std::vector<Unigine::Math::ivec4> _bounds;
+	};
+
+
+	// Stable storage for the event connections widgets own, released slots are reused instead of freed
+	class ConnectionPool
 	{
 	public:
-		WidgetBase(const ScaleSettings& scaleSettings) : _scaleSettings(scaleSettings) {}
+		struct Statistics
+		{
+			uint32_t liveCount = 0;
+			uint32_t capacity = 0;
+		};
+
+		static ConnectionPool& get()
+		{
+			static ConnectionPool instance;
+			return instance;
+		}
+
+		Unigine::EventConnection* acquire();
+		void release(Unigine::EventConnection* connection);
+
+		const Statistics& getStatistics() const { return _statistics; }
+	private:
+		ConnectionPool() = default;
+
+		std::deque<Unigine::EventConnection> _connections;
+		std::vector<Unigine::EventConnection*> _freeConnections;
+		Statistics _statistics;
+	};
+
+
+	// What a widget holds on its own, engine widgets are counted but their internals can't be sized
+	struct Footprint
+	{
+		uint32_t objectCount = 0;
+		uint32_t engineWidgetCount = 0;
+		uint32_t stringCount = 0;
+		size_t stringBytes = 0;
+		uint32_t textureCount = 0;
+		size_t bytes = 0;
+
+		void addString(const Unigine::String& string);
+		Footprint& operator+=(const Footprint& other);
+	};
+
+
+	// Footprint of every widget in a tree, nodes are stored depth first
+	struct FootprintReport
+	{
+		struct Node
+		{
+			Unigine::String type;
+			int32_t parent = -1;
+			int32_t depth = 0;
+			Footprint self;
+			Footprint total;
+		};
+
+		std::vector<Node> nodes;
+		uint32_t distinctTextureCount = 0;
+		size_t textureBytes = 0;
+
+		static FootprintReport build(const std::shared_ptr<WidgetBase>& root);
+		Unigine::String toJson() const;
+		bool saveJson(const char* path) const;
+	};
+
+
+	// One widget's share of a LayoutJob, filled by WidgetBase::planLayout and applied by WidgetBase::commitLayout
+	struct LayoutRecord
+	{
+		std::shared_ptr<WidgetBase> widget;
+		int32_t width = 0;
+		int32_t height = 0;
+		bool isContainer = false;
+
+		int32_t maxFontSize = 0;
+		int32_t maxFontHSpacing = 0;
+		int32_t maxFontVSpacing = 0;
+	};
+
+
+	// Resumable layout pass. step() only plans, without touching engine widgets, and commit() applies the whole
+	// plan at once, so the previous layout stays on screen until then.
+	class LayoutJob
+	{
+	public:
+		void start(const std::shared_ptr<WidgetBase>& root, int32_t width, int32_t height);
+		// Plans widgets until the queue is empty or the time is up, at least one per call. True once everything is planned
+		bool step(long long maxMicroseconds);
+		bool commit();
+		void cancel();
+
+		bool isRunning() const { return _isRunning; }
+		bool isPlanned() const { return _isRunning && _queue.empty(); }
+		size_t getPlannedCount() const { return _records.size(); }
+		size_t getQueuedCount() const { return _queue.size(); }
+
+		void push(const std::shared_ptr<WidgetBase>& widget, int32_t width, int32_t height);
+		// Hidden label for measuring text in a font, so planning never changes what a visible label shows
+		const Unigine::WidgetLabelPtr& getMeasureLabel(ResourceId font);
+	private:
+		std::vector<LayoutRecord> _queue;
+		std::vector<LayoutRecord> _records;
+		Unigine::HashMap<ResourceId, Unigine::WidgetLabelPtr> _measureLabels;
+		bool _isRunning = false;
+	};
+
+
+	class WidgetBase : public std::enable_shared_from_this<WidgetBase>
+	{
+	public:
+		WidgetBase(const ScaleSettings& scaleSettings) : _scaleSettings(scaleSettings), _isArenaAllocated(Arena::getCurrentResource() != std::pmr::get_default_resource()) {}
+		virtual ~WidgetBase() = default;
 		void setGui(const Unigine::GuiPtr& gui) { _widget->setGui(gui); }
 		virtual void resize(int32_t width, int32_t height);
 		operator const Unigine::WidgetPtr& () const { return _widget; }
@@ -73,10 +638,52 @@ namespace noMoPi
 		virtual void translate() {}
 		virtual void tick(float deltaTime) {}
 		virtual void addChild(const std::shared_ptr<WidgetBase>& widget) {}
+		virtual bool removeChild(const WidgetBase* widget) { return false; }
+		// Returns the widget to its freshly constructed state for reuse, false if the type can't be reused
+		virtual bool reset() { return false; }
+		void setScaleSettings(const ScaleSettings& scaleSettings) { _scaleSettings = scaleSettings; }
+		virtual void collectTextures(std::vector<ResourceId>& textures) const {}
+		virtual void collectGlyphs(GlyphWarmup& warmup) const {}
+		// Adds this widget alone, containers don't include their children
+		virtual void collectFootprint(Footprint& footprint) const;
+
+		// Relative to the parent content origin, set by the parent layout
+		void setLayoutPosition(int32_t x, int32_t y) { _layoutPosition = Unigine::Math::ivec2(x, y); }
+		Unigine::Math::ivec4 getLayoutRect() const { return Unigine::Math::ivec4(_layoutPosition.x, _layoutPosition.y, _widget->getWidth(), _widget->getHeight()); }
+		struct RayHit
+		{
+			WidgetBase* widget = nullptr;
+			float distance = 0.f;
+		};
+
+		// Deepest Interactive widget under a point given relative to this widget
+		virtual WidgetBase* pick(int32_t x, int32_t y, bool useIndex = true);
+		// Every Interactive widget the ray crosses, origin is relative to this widget
+		virtual void pickRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<RayHit>& hits);
+		bool isInteractive() const { return _isInteractive; }
+		// This widget or a descendant is Interactive, updated when the parent places its children
+		bool containsInteractive() const { return _containsInteractive; }
+
+		// Duration of the last pass over this subtree, only measured while the UI has a frame budget
+		long long getPassMicroseconds() const { return _passMicroseconds; }
+		bool isArenaAllocated() const { return _isArenaAllocated; }
+
+		// LayoutJob steps: plan fills the record and queues children, commit applies it to this widget alone
+		virtual void planLayout(LayoutJob& job, LayoutRecord& record) {}
+		virtual void commitLayout(const LayoutRecord& record) { resize(record.width, record.height); }
 	protected:
+		friend class FrameBudgetScope;
+		template<typename T>
+		friend std::shared_ptr<T> makeWidget(const ScaleSettings& scaleSettings);
+
 		Unigine::WidgetPtr _widget;
 
 		ScaleSettings _scaleSettings;
+		Unigine::Math::ivec2 _layoutPosition;
+		long long _passMicroseconds = 0;
+		bool _isArenaAllocated = false;
+		bool _isInteractive = false;
+		bool _containsInteractive = false;
 	};
 
 
@@ -84,6 +691,7 @@ namespace noMoPi
 	{
 	public:
 		WidgetContainer(const ScaleSettings& scaleSettings) : WidgetBase(scaleSettings) {}
+		virtual ~WidgetContainer();
 		virtual void resize(int32_t width, int32_t height);
 		virtual void translate();
 		virtual void tick(float deltaTime);
@@ -91,6 +699,12 @@ namespace noMoPi
 		virtual int32_t getInnerWidth() const;
 
 		virtual void addChild(const std::shared_ptr<WidgetBase>& widget);
+		virtual bool removeChild(const WidgetBase* widget);
+		virtual bool reset();
+		virtual void collectTextures(std::vector<ResourceId>& textures) const;
+		virtual void collectGlyphs(GlyphWarmup& warmup) const;
+		virtual void collectFootprint(Footprint& footprint) const;
+		const std::pmr::vector<std::shared_ptr<WidgetBase>>& getChildren() const { return _childWidgets; }
 
 		WidgetContainer* setPadding(float top, float bottom, float left, float right);
 		WidgetContainer* setPaddingEqual(bool isPaddingEqual);
@@ -99,12 +713,25 @@ namespace noMoPi
 		WidgetContainer* setBackgroundColor(float r, float g, float b, float a = 1.f);
 		WidgetContainer* setBackgroundColor(const Unigine::Math::vec4& color);
 		WidgetContainer* setBackgroundColor(int32_t r, int32_t g, int32_t b, int32_t a = 255);
-		WidgetContainer* setBackgroundTexture(const Unigine::String& texture);
+		WidgetContainer* setBackgroundTexture(const char* texture);
+		WidgetContainer* setBackgroundTexture(ResourceId texture);
 		WidgetContainer* setBackgroundTextureFiltering(int32_t filtering);
+		// Borders are insets in texture pixels, they keep their size scaled by Settings::getScale while the center stretches
+		WidgetContainer* setBackgroundNineSlice(const char* texture, int32_t left, int32_t right, int32_t top, int32_t bottom);
+		WidgetContainer* setBackgroundNineSlice(ResourceId texture, int32_t left, int32_t right, int32_t top, int32_t bottom);
 
 		int32_t getWidth() const { return _widget->getWidth(); }
 		int32_t getHeight() const { return _widget->getHeight(); }
+
+		virtual WidgetBase* pick(int32_t x, int32_t y, bool useIndex = true);
+		virtual void pickRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<RayHit>& hits);
+
+		virtual void planLayout(LayoutJob& job, LayoutRecord& record);
+		virtual void commitLayout(const LayoutRecord& record);
 	protected:
+		friend class LayoutTrace;
+		friend class LayoutJob;
+
 		enum class Padding : uint8_t
 		{
 			Top,
@@ -113,36 +740,433 @@ namespace noMoPi
 			Right
 		};
 
+		// Children are sized one after another, so a pass can stop between two of them and continue later
+		struct ChildSizing
+		{
+			int32_t parentWidth = 0;
+			int32_t parentHeight = 0;
+			int32_t spaceLeft = 0;
+			int32_t fillWidgetsCount = 0;
+			float totalWidgetsWeight = 0.f;
+			bool isHorizontal = false;
+		};
+
+		virtual void _beginResize(int32_t width, int32_t height);
 		void _calculatePadding();
+		Unigine::Math::ivec4 _calculatePaddingInPixels(int32_t width, int32_t height) const;
+		Unigine::Math::ivec2 _getInnerSize(const Unigine::Math::ivec2& size, const Unigine::Math::ivec4& paddingInPixels) const;
 		void _calculateSpacing();
-		virtual void _resizeChildren();
+		void _resizeChildren();
+		// Queues children with the sizes _resizeChildren would give them for this size
+		virtual void _planChildren(LayoutJob& job, int32_t width, int32_t height);
+		virtual ChildSizing _beginChildSizing(const Unigine::Math::ivec2& size, const Unigine::Math::ivec4& paddingInPixels) const;
+		virtual bool _nextChildSize(ChildSizing& sizing, const WidgetBase& child, Unigine::Math::ivec2& size) const;
+		void _placeChildren();
+		virtual Unigine::Math::ivec2 _getScrollOffset() const { return Unigine::Math::ivec2(0, 0); }
+		void _updateNineSlice();
 
-		std::vector<std::shared_ptr<WidgetBase>> _childWidgets;
-		std::vector<Unigine::WidgetVBoxPtr> _spacers;
+		std::pmr::vector<std::shared_ptr<WidgetBase>> _childWidgets{ Arena::getCurrentResource() };
+		std::pmr::vector<Unigine::WidgetVBoxPtr> _spacers{ Arena::getCurrentResource() };
 		Unigine::Math::vec4 _padding;
 		Unigine::Math::ivec4 _paddingInPixels;
 		bool _isPaddingEqual = false;
 		float _spacing = 0.f;
 		bool _ignorePadding = false;
+		ResourceId _backgroundTexture = InvalidResource;
+		bool _isNineSliced = false;
+
+		// containers with fewer children are scanned linearly
+		static constexpr size_t _spatialIndexThreshold = 16;
+		SpatialIndex _childIndex;
+		std::vector<Unigine::Math::ivec4> _childRects;
+		std::vector<int32_t> _pickCandidates;
+		std::vector<SpatialIndex::RayHit> _rayCandidates;
+	};
+
+
+	// 32-bit widget id, the low bits index a WidgetPool slot and the high bits hold the slot generation
+	struct WidgetHandle
+	{
+		static constexpr uint32_t IndexBits = 20;
+		static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+		static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+		uint32_t id = 0;
+
+		// index is stored off by one so a zero id is never valid
+		static WidgetHandle make(uint32_t index, uint32_t generation) { return { ((generation & GenerationMask) << IndexBits) | ((index + 1) & IndexMask) }; }
+		uint32_t getIndex() const { return (id & IndexMask) - 1; }
+		uint32_t getGeneration() const { return id >> IndexBits; }
+		bool isNull() const { return id == 0; }
+
+		bool operator==(const WidgetHandle& other) const { return id == other.id; }
+		bool operator!=(const WidgetHandle& other) const { return id != other.id; }
+	};
+
+
+	// UI owned widget storage addressed by generational handles, a stale handle resolves to nullptr instead of dangling
+	class WidgetPool
+	{
+	public:
+		template<typename T>
+		WidgetHandle create(const ScaleSettings& scaleSettings = ScaleSettings()) { return add(T::create(scaleSettings)); }
+		WidgetHandle add(const std::shared_ptr<WidgetBase>& widget);
+
+		// linear in the widget's depth
+		bool isValid(WidgetHandle handle) const;
+		WidgetBase* get(WidgetHandle handle) const;
+		template<typename T>
+		T* get(WidgetHandle handle) const { return dynamic_cast<T*>(get(handle)); }
+		const std::shared_ptr<WidgetBase>& getShared(WidgetHandle handle) const;
+
+		bool addChild(WidgetHandle parent, WidgetHandle child);
+		// Makes every handle in the subtree stale at once, the widgets are released by update()
+		void destroy(WidgetHandle handle);
+		void update();
+		void flush();
+
+		void setReclaimBudget(int32_t slotsPerUpdate) { _reclaimBudget = slotsPerUpdate; }
+		uint32_t getLiveCount() const { return _liveCount; }
+	private:
+		struct Slot
+		{
+			std::shared_ptr<WidgetBase> widget;
+			uint32_t generation = 0;
+			int32_t parent = -1;
+			int32_t firstChild = -1;
+			int32_t prevSibling = -1;
+			int32_t nextSibling = -1;
+			bool isDestroyed = false;
+		};
+
+		void _unlink(int32_t index);
+		void _reclaim(int32_t index);
+
+		std::vector<Slot> _slots;
+		std::vector<int32_t> _freeSlots;
+		std::vector<int32_t> _reclaimQueue;
+		int32_t _reclaimBudget = 256;
+		uint32_t _liveCount = 0;
+	};
+
+
+	// Work done by every UI since the last UI::tick, plain increments that stay on in release builds
+	struct FrameCounters
+	{
+		int32_t widgetsLaidOut = 0;
+		// virtualized content without an engine widget, such as off-screen DataGrid cells
+		int32_t widgetsSkipped = 0;
+		int32_t textMeasurements = 0;
+		int32_t measureCacheHits = 0;
+		int32_t measureCacheMisses = 0;
+
+		static FrameCounters& getCurrent() { static FrameCounters counters; return counters; }
+	};
+
+	struct FrameStatistics
+	{
+		FrameCounters counters;
+		double layoutMilliseconds = 0.0;
+		double tickMilliseconds = 0.0;
+		// engine allocations in the last frame, -1 when the engine runs without memory statistics
+		int32_t allocationCount = -1;
+	};
+
+
+	// Attributes heap allocations to UI operations, the application forwards its allocations to onAllocate
+	class AllocationTracker
+	{
+	public:
+		enum class Operation : uint8_t
+		{
+			UpdateLayout,
+			Translate,
+			Tick,
+			AddChild,
+			Count
+		};
+
+		// Nested operations count for every operation around them, a tick includes the layout it requested
+		struct Counters
+		{
+			uint64_t callCount = 0;
+			uint64_t allocationCount = 0;
+			uint64_t bytes = 0;
+		};
+
+		static AllocationTracker& get() { static AllocationTracker instance; return instance; }
+
+		static void onAllocate(size_t bytes);
+
+		void setEnabled(bool isEnabled) { _isEnabled = isEnabled; }
+		bool isEnabled() const { return _isEnabled; }
+		// Test mode for zero allocation frames: every tick after the warm-up ticks that allocates is logged as an error
+		void setTickAllocationCheck(bool isEnabled, uint32_t warmupTickCount = 3);
+		uint32_t getFailedTickCount() const { return _failedTickCount; }
+
+		const Counters& getCounters(Operation operation) const { return _counters[static_cast<size_t>(operation)]; }
+		void resetCounters();
+	private:
+		friend class AllocationScope;
+
+		static uint32_t& _activeOperations();
+
+		Counters _counters[static_cast<size_t>(Operation::Count)];
+		bool _isEnabled = false;
+
+		bool _isTickCheckEnabled = false;
+		uint32_t _warmupTickCount = 0;
+		uint32_t _checkedTickCount = 0;
+		uint32_t _failedTickCount = 0;
+	};
+
+	class AllocationScope
+	{
+	public:
+		explicit AllocationScope(AllocationTracker::Operation operation);
+		~AllocationScope();
+
+		AllocationScope(const AllocationScope&) = delete;
+		AllocationScope& operator=(const AllocationScope&) = delete;
+	private:
+		AllocationTracker::Operation _operation;
+		uint32_t _previousOperations = 0;
+		uint64_t _allocationCount = 0;
+		uint64_t _bytes = 0;
+		bool _isTracking = false;
 	};
 
 
+	// Binary record of layout pass inputs and results. noMoPiReplay runs it headlessly, with the recorded text
+	// measurements standing in for the fonts.
+	class LayoutTrace
+	{
+	public:
+		static constexpr uint32_t Magic = 0x54504d4e; // "NMPT"
+		static constexpr uint32_t Version = 1;
+
+		enum class NodeType : uint8_t
+		{
+			VBox,
+			HBox,
+			ScrollBox,
+			Label,
+			EditLine,
+			// any other widget, replayed as an empty box that only keeps the rect its parent gives it
+			Leaf
+		};
+
+		struct Node
+		{
+			NodeType type = NodeType::Leaf;
+			int32_t parent = -1;
+			ScaleSettings scaleSettings;
+
+			// containers, padding is top, bottom, left, right
+			Unigine::Math::vec4 padding;
+			bool isPaddingEqual = false;
+			float spacing = 0.f;
+			bool ignorePadding = false;
+			int32_t itemCount = 0;
+
+			Unigine::String text;
+			float fontSize = 1.f;
+			bool fontWrap = false;
+			float fontMaxHSpacing = 0.f;
+			float fontMaxVSpacing = 0.f;
+			float fontHSpacing = 0.f;
+			float fontVSpacing = 0.f;
+		};
+
+		struct Result
+		{
+			Unigine::Math::ivec4 rect;
+			// the applied font size of labels and edit lines, zero for other widgets
+			int32_t fontSize = 0;
+		};
+
+		struct Pass
+		{
+			Unigine::Math::ivec2 guiSize;
+			// index into trees, a new tree is stored only when a pass sees a different one
+			int32_t tree = 0;
+			std::vector<Unigine::Math::ivec2> measurements;
+			std::vector<Result> results;
+		};
+
+		FontSizePolicy::Mode fontSizeMode = FontSizePolicy::Mode::Exact;
+		std::vector<int32_t> fontSizes;
+		std::vector<std::vector<Node>> trees;
+		std::vector<Pass> passes;
+
+		bool save(const char* path) const;
+		bool load(const char* path);
+
+		// UI::updateLayout wraps every pass in these while it records
+		void beginPass(const std::shared_ptr<WidgetBase>& root, const Unigine::Math::ivec2& guiSize);
+		void endPass();
+
+		void applyFontSizePolicy() const;
+		// Widgets of a recorded tree, nodes come back in the recorded order and the first one is the root
+		std::vector<std::shared_ptr<WidgetBase>> buildTree(int32_t tree) const;
+		// Text measurements come from the pass instead of the fonts until endReplay
+		void beginReplay(int32_t pass);
+		void endReplay();
+		int32_t compareResults(int32_t pass, const std::vector<std::shared_ptr<WidgetBase>>& nodes) const;
+
+		// Every layout text measurement goes through here, so an active trace can record or replace it
+		static Unigine::Math::ivec2 measureText(const Unigine::WidgetLabelPtr& label, const Unigine::String& text);
+	private:
+		static LayoutTrace*& _current();
+		static Result _getResult(const WidgetBase* widget);
+		void _snapshot(const std::shared_ptr<WidgetBase>& root);
+
+		bool _isReplaying = false;
+		int32_t _pass = -1;
+		size_t _measurement = 0;
+
+		std::vector<Node> _nodes;
+		std::vector<const WidgetBase*> _widgets;
+		std::vector<uint8_t> _treeBytes, _lastTreeBytes;
+	};
+
+
+	// Times a widget pass into WidgetBase::getPassMicroseconds, costs a flag check when no UI with a frame budget is running
+	class FrameBudgetScope
+	{
+	public:
+		explicit FrameBudgetScope(WidgetBase& widget);
+		FrameBudgetScope(WidgetBase& widget, bool isTiming);
+		~FrameBudgetScope();
+
+		FrameBudgetScope(const FrameBudgetScope&) = delete;
+		FrameBudgetScope& operator=(const FrameBudgetScope&) = delete;
+	private:
+		static bool& _isTiming();
+
+		WidgetBase* _widget = nullptr;
+		long long _begin = 0;
+		bool _wasTiming = false;
+		bool _isRoot = false;
+	};
+
+
+	class PerformanceOverlay;
+
 	class UI
 	{
 	public:
-		UI() {}
-		UI(const Unigine::GuiPtr& gui) : _gui(gui) {}
+		UI();
+		UI(const Unigine::GuiPtr& gui);
 		void setRootWidget(const std::shared_ptr<WidgetBase>& widget);
+		void setRootWidget(WidgetHandle widget) { setRootWidget(_widgets.getShared(widget)); }
+		WidgetPool& getWidgets() { return _widgets; }
+		FootprintReport getFootprint() const { return FootprintReport::build(_rootWidget); }
 		void updateLayout();
 		void setDictionary(const char* dictionary);
 		void setLanguage(const char* language);
 		void translate();
+		// Call every frame: it dispatches pointer events, loads textures and runs requested layouts
 		void tick();
+		void tick(float deltaTime);
 		void addChild(const std::shared_ptr<WidgetBase>& widget);
+
+		struct HitTestBenchmark
+		{
+			int32_t queryCount = 0;
+			double indexedMilliseconds = 0.0;
+			double linearMilliseconds = 0.0;
+			int32_t mismatchCount = 0;
+		};
+
+		WidgetBase* pick(int32_t x, int32_t y, bool useIndex = true);
+		// Hits are sorted by distance along the ray
+		void pickRay(const Unigine::Math::vec2& origin, const Unigine::Math::vec2& direction, std::vector<WidgetBase::RayHit>& hits);
+		// Picks random points over the gui through the spatial indices and by linear traversal
+		HitTestBenchmark benchmarkHitTest(int32_t queryCount);
+
+		// Feeds a pointer state in gui pixels, tick() does this for the mouse, other pointers can call it any number of times per frame
+		void processPointer(int32_t x, int32_t y, int32_t buttons);
+		// Deferred events are collected until tick() and dispatched in one batch, enter/leave pairs that cancel out are dropped
+		void setDeferredEvents(bool isDeferred);
+		bool isDeferredEvents() const { return _isDeferredEvents; }
+		// Handlers call this instead of updateLayout(), tick() runs a single layout pass after dispatching
+		void requestLayout() { _isLayoutRequested = true; }
+		// Outer profiler marker around this UI's passes, so captures tell screens apart
+		void setProfilerName(const char* name) { _profilerName = name; }
+
+		// Statistics of the last tick(), layout time includes every updateLayout() since the tick before
+		const FrameStatistics& getFrameStatistics() const { return _frameStatistics; }
+		// Shown on top of the root widget and not counted in the statistics, nullptr removes it
+		void setOverlay(const std::shared_ptr<PerformanceOverlay>& overlay);
+		const std::shared_ptr<PerformanceOverlay>& getOverlay() const { return _overlay; }
+
+		// Records every layout pass until stopTrace, for noMoPiReplay
+		void startTrace();
+		bool stopTrace(const char* path);
+		bool isTracing() const { return _trace != nullptr; }
+
+		// Time all passes of this UI may take in one frame, zero turns the watchdog off. The first pass that goes over
+		// it in a frame is logged with its phase and the widget path that took most of the time.
+		void setFrameBudget(float milliseconds);
+		float getFrameBudget() const { return _frameBudgetMicroseconds / 1000.f; }
+		uint32_t getOverBudgetFrameCount() const { return _overBudgetFrameCount; }
+		// With a frame budget, requestLayout() runs as a LayoutJob spread over ticks, updateLayout() still finishes at once
+		void setLayoutSpreading(bool isSpreading);
+		bool isLayoutSpreading() const { return _isLayoutSpreading; }
+		bool isLayoutPending() const { return _isLayoutRequested || _layoutJob.isRunning(); }
 	private:
+		enum class EventType : uint8_t
+		{
+			Enter,
+			Leave,
+			Clicked
+		};
+
+		struct QueuedEvent
+		{
+			EventType type = EventType::Enter;
+			WidgetBase* target = nullptr;
+			std::weak_ptr<WidgetBase> widget;
+			int32_t mouse = 0;
+		};
+
+		void _updateInput();
+		void _queueEvent(EventType type, WidgetBase* target, int32_t mouse = 0);
+		void _runEvent(EventType type, WidgetBase* target, int32_t mouse);
+		void _dispatchEvents();
+		void _resizeOverlay(const Unigine::Math::ivec2& guiSize);
+		void _spreadLayout(long long frameBegin);
+		void _checkFrameBudget(const char* phase, long long microseconds);
+
 		Unigine::GuiPtr _gui;
 		std::shared_ptr<WidgetBase> _rootWidget;
-		const char* _currentDictionary = "";
+		Unigine::String _profilerName = "noMoPi::UI";
+
+		FrameStatistics _frameStatistics;
+		long long _layoutMicroseconds = 0;
+		std::shared_ptr<PerformanceOverlay> _overlay;
+		std::unique_ptr<LayoutTrace> _trace;
+
+		long long _frameBudgetMicroseconds = 0;
+		long long _frameMicroseconds = 0;
+		uint32_t _overBudgetFrameCount = 0;
+		bool _isOverBudget = false;
+		bool _isTicking = false;
+		bool _isLayoutSpreading = false;
+		LayoutJob _layoutJob;
+		ResourceId _currentDictionary = InvalidResource;
+		WidgetPool _widgets;
+
+		std::weak_ptr<WidgetBase> _hoveredWidget;
+		std::weak_ptr<WidgetBase> _pressedWidget;
+		int32_t _mouseButtons = 0;
+
+		bool _isDeferredEvents = false;
+		bool _isLayoutRequested = false;
+		std::vector<QueuedEvent> _eventQueue;
+		// the batch being dispatched, handlers queue into _eventQueue meanwhile
+		std::vector<QueuedEvent> _dispatchedEvents;
 	};
 
 
@@ -151,8 +1175,8 @@ namespace noMoPi
 	public:
 		HBox(const ScaleSettings& scaleSettings);
 
-		static std::shared_ptr<HBox> create() { return std::make_shared<HBox>(ScaleSettings()); }
-		static std::shared_ptr<HBox> create(const ScaleSettings& scaleSettings) { return std::make_shared<HBox>(scaleSettings); }
+		static std::shared_ptr<HBox> create() { return makeWidget<HBox>(ScaleSettings()); }
+		static std::shared_ptr<HBox> create(const ScaleSettings& scaleSettings) { return makeWidget<HBox>(scaleSettings); }
 	};
 
 
@@ -161,8 +1185,8 @@ namespace noMoPi
 	public:
 		VBox(const ScaleSettings& scaleSettings);
 
-		static std::shared_ptr<VBox> create() { return std::make_shared<VBox>(ScaleSettings()); }
-		static std::shared_ptr<VBox> create(const ScaleSettings& scaleSettings) { return std::make_shared<VBox>(scaleSettings); }
+		static std::shared_ptr<VBox> create() { return makeWidget<VBox>(ScaleSettings()); }
+		static std::shared_ptr<VBox> create(const ScaleSettings& scaleSettings) { return makeWidget<VBox>(scaleSettings); }
 	};
 
 
@@ -171,8 +1195,8 @@ namespace noMoPi
 	public:
 		Label(const ScaleSettings& scaleSettings);
 
-		static std::shared_ptr<Label> create() { return std::make_shared<Label>(ScaleSettings()); }
-		static std::shared_ptr<Label> create(const ScaleSettings& scaleSettings) { return std::make_shared<Label>(scaleSettings); }
+		static std::shared_ptr<Label> create() { return makeWidget<Label>(ScaleSettings()); }
+		static std::shared_ptr<Label> create(const ScaleSettings& scaleSettings) { return makeWidget<Label>(scaleSettings); }
 
 		Label* setText(const char* text, bool isTranslatable = true);
 		void _countTextLines(const char* text);
@@ -184,16 +1208,36 @@ namespace noMoPi
 		Label* setFontVSpacing(float spacing);
 		Label* setTextAlign(Align horizontal, Align vertical);
 		Label* setDefaultFont(int32_t fontIndex);
+		Label* setFont(ResourceId font);
 		Label* setTextTypingAnimationCompletion(float completion);
 
 		virtual void resize(int32_t width, int32_t height);
 		void _updateFont(int32_t width);
 		virtual void translate();
+		virtual void collectGlyphs(GlyphWarmup& warmup) const;
+		virtual void collectFootprint(Footprint& footprint) const;
+		virtual bool reset();
 
+		virtual void planLayout(LayoutJob& job, LayoutRecord& record);
+		virtual void commitLayout(const LayoutRecord& record);
 	protected:
+		friend class LayoutTrace;
+
+		struct FontParams
+		{
+			int32_t maxFontSize = 0;
+			int32_t maxFontHSpacing = 0;
+			int32_t maxFontVSpacing = 0;
+		};
+
 		void _calculateMaxFontParams();
+		// Measures through the given label, which is left with the probe font size and spacing
+		FontParams _calculateFontParams(const Unigine::WidgetLabelPtr& label, int32_t width, int32_t height) const;
+		void _applyFontSize(int32_t fontSize);
 
 		Unigine::WidgetLabelPtr _label;
+		ResourceId _font = InvalidResource;
+		FontSizeUsage _fontSizeUsage;
 
 		bool _isTextTranslatable = false;
 		Unigine::String _targetText, _keyText;
@@ -219,14 +1263,20 @@ namespace noMoPi
 	public:
 		ScrollBox(const ScaleSettings& scaleSettings);
 
-		static std::shared_ptr<ScrollBox> create() { return std::make_shared<ScrollBox>(ScaleSettings()); }
-		static std::shared_ptr<ScrollBox> create(const ScaleSettings& scaleSettings) { return std::make_shared<ScrollBox>(scaleSettings); }
+		static std::shared_ptr<ScrollBox> create() { return makeWidget<ScrollBox>(ScaleSettings()); }
+		static std::shared_ptr<ScrollBox> create(const ScaleSettings& scaleSettings) { return makeWidget<ScrollBox>(scaleSettings); }
 
-		virtual void resize(int32_t width, int32_t height);
+		virtual bool reset();
 		ScrollBox* setVisibleItemCount(int32_t itemCount);
 	protected:
-		virtual void _resizeChildren();
+		virtual void _beginResize(int32_t width, int32_t height);
+		virtual void _planChildren(LayoutJob& job, int32_t width, int32_t height);
+		virtual ChildSizing _beginChildSizing(const Unigine::Math::ivec2& size, const Unigine::Math::ivec4& paddingInPixels) const;
+		virtual bool _nextChildSize(ChildSizing& sizing, const WidgetBase& child, Unigine::Math::ivec2& size) const;
+		virtual Unigine::Math::ivec2 _getScrollOffset() const;
 	private:
+		friend class LayoutTrace;
+
 		int32_t _itemCount = 0;
 	};
 
@@ -236,16 +1286,23 @@ namespace noMoPi
 	public:
 		EditLine(const ScaleSettings& scaleSettings);
 
-		static std::shared_ptr<EditLine> create() { return std::make_shared<EditLine>(ScaleSettings()); }
-		static std::shared_ptr<EditLine> create(const ScaleSettings& scaleSettings) { return std::make_shared<EditLine>(scaleSettings); }
+		static std::shared_ptr<EditLine> create() { return makeWidget<EditLine>(ScaleSettings()); }
+		static std::shared_ptr<EditLine> create(const ScaleSettings& scaleSettings) { return makeWidget<EditLine>(scaleSettings); }
 
 		virtual void resize(int32_t width, int32_t height);
 		EditLine* setDefaultFont(int32_t fontIndex);
+		EditLine* setFont(ResourceId font);
+		virtual void collectGlyphs(GlyphWarmup& warmup) const;
+		virtual void collectFootprint(Footprint& footprint) const;
+		virtual bool reset();
 
 	private:
+		void _createWidget();
 		void _calculateMaxFontSize();
 
 		int32_t _maxFontSize = 0;
+		ResourceId _font = InvalidResource;
+		FontSizeUsage _fontSizeUsage;
 
 		float _magicMaxFontProportion = static_cast<float>(999) / 1124;
 	};
@@ -254,26 +1311,413 @@ namespace noMoPi
 	{
 	public:
 		CheckBox(const ScaleSettings& scaleSettings);
+		virtual ~CheckBox();
+		virtual void collectTextures(std::vector<ResourceId>& textures) const;
+		virtual void collectFootprint(Footprint& footprint) const;
+		virtual bool reset();
+
+		static std::shared_ptr<CheckBox> create() { return makeWidget<CheckBox>(ScaleSettings()); }
+		static std::shared_ptr<CheckBox> create(const ScaleSettings& scaleSettings) { return makeWidget<CheckBox>(scaleSettings); }
 
-		static std::shared_ptr<CheckBox> create() { return std::make_shared<CheckBox>(ScaleSettings()); }
-		static std::shared_ptr<CheckBox> create(const ScaleSettings& scaleSettings) { return std::make_shared<CheckBox>(scaleSettings); }
+		CheckBox* setChecked(bool isChecked);
+		bool isChecked() const { return _isChecked; }
+		Unigine::Event<CheckBox*, bool>& getEventToggled() { return _eventToggled; }
 
 		Unigine::TexturePtr _backgroundTexture, _tickTexture;
+	private:
+		Unigine::WidgetSpritePtr _sprite;
+		int32_t _tickLayer = 1;
+		bool _isChecked = false;
+
+		Unigine::EventConnection* _clickConnection = nullptr;
+		Unigine::EventInvoker<CheckBox*, bool> _eventToggled;
+
+		bool _isAtlased = false;
+		ResourceId _backgroundTextureId = InvalidResource;
+		ResourceId _tickTextureId = InvalidResource;
+	};
+
+	// Table widget that keeps engine labels only for visible cells and reuses them while scrolling
+	class DataGrid : public WidgetBase
+	{
+	public:
+		DataGrid(const ScaleSettings& scaleSettings);
+		virtual ~DataGrid();
+
+		static std::shared_ptr<DataGrid> create() { return makeWidget<DataGrid>(ScaleSettings()); }
+		static std::shared_ptr<DataGrid> create(const ScaleSettings& scaleSettings) { return makeWidget<DataGrid>(scaleSettings); }
+
+		DataGrid* setColumnCount(int32_t columnCount);
+		DataGrid* setRowCount(int32_t rowCount);
+		DataGrid* setColumnWeight(int32_t column, float weight);
+		DataGrid* setVisibleRowCount(int32_t rowCount);
+		DataGrid* setVisibleColumnCount(int32_t columnCount);
+		DataGrid* setFirstVisibleRow(int32_t row);
+		DataGrid* setFirstVisibleColumn(int32_t column);
+		DataGrid* setFontSize(float fontSize);
+		DataGrid* setDefaultFont(int32_t fontIndex);
+		DataGrid* setFont(ResourceId font);
+
+		DataGrid* setCell(int32_t column, int32_t row, const char* value);
+		DataGrid* setColumn(int32_t column, const std::vector<Unigine::String>& values);
+
+		int32_t getColumnCount() const { return static_cast<int32_t>(_columns.size()); }
+		int32_t getRowCount() const { return _rowCount; }
+		const Unigine::String& getCell(int32_t column, int32_t row) const;
+
+		virtual void resize(int32_t width, int32_t height);
+		virtual void tick(float deltaTime);
+		virtual void collectGlyphs(GlyphWarmup& warmup) const;
+		virtual void collectFootprint(Footprint& footprint) const;
+
+	protected:
+		struct Column
+		{
+			std::vector<Unigine::String> values;
+			// text widths at _measureFontSize, -1 when not measured yet
+			std::vector<int32_t> widths;
+			std::vector<int32_t> dirtyRows;
+			Unigine::HashMap<Unigine::String, int32_t> measurements;
+			int32_t widestText = 0;
+			// rows measured at widestText, every row is measured again when it drops to zero
+			int32_t widestCount = 0;
+			float weight = 1.f;
+			int32_t fontSize = 0;
+			bool isMeasureDirty = true;
+			bool isRescanNeeded = true;
+		};
+
+		struct Cell
+		{
+			Unigine::WidgetLabelPtr label;
+			int32_t column = -1;
+			int32_t row = -1;
+			bool isDirty = true;
+		};
+
+		void _rebuildCells();
+		void _bindCells();
+		void _measureColumn(Column& column);
+		void _measureRow(Column& column, int32_t row);
+		void _invalidateWidth(Column& column, int32_t row);
+		// Forgets a row's width, the column needs a rescan if it was the last one at the widest width
+		void _dropWidth(Column& column, int32_t row);
+		void _updateColumnFonts();
+		void _refreshCells();
+		bool _isCellVisible(int32_t column, int32_t row) const;
+		bool _checkColumn(int32_t column) const;
+		bool _checkCell(int32_t column, int32_t row) const;
+
+		std::vector<Column> _columns;
+		std::vector<Unigine::WidgetHBoxPtr> _rows;
+		// visible cells stored row by row
+		std::vector<Cell> _cells;
+		std::vector<int32_t> _columnWidths;
+
+		Unigine::WidgetLabelPtr _measureLabel;
+		ResourceId _font = InvalidResource;
+
+		int32_t _rowCount = 0;
+		int32_t _visibleRowCount = 1;
+		int32_t _visibleColumnCount = 1;
+		int32_t _firstVisibleRow = 0;
+		int32_t _firstVisibleColumn = 0;
+		int32_t _rowHeight = 0;
+		float _fontSize = 1.f;
+
+		const int32_t _measureFontSize = 100;
+		const uint32_t _maxCachedMeasurements = 4096;
+	};
+
+	// Line graph of the last pushed values, scaled so the largest one fills the widget height
+	class Sparkline : public WidgetBase
+	{
+	public:
+		Sparkline(const ScaleSettings& scaleSettings);
+
+		static std::shared_ptr<Sparkline> create() { return makeWidget<Sparkline>(ScaleSettings()); }
+		static std::shared_ptr<Sparkline> create(const ScaleSettings& scaleSettings) { return makeWidget<Sparkline>(scaleSettings); }
+
+		Sparkline* setHistoryLength(int32_t length);
+		Sparkline* setColor(const Unigine::Math::vec4& color);
+		Sparkline* push(float value);
+
+		virtual void resize(int32_t width, int32_t height);
+		virtual void collectFootprint(Footprint& footprint) const;
+	private:
+		void _updatePoints();
+
+		Unigine::WidgetCanvasPtr _canvas;
+		int32_t _line = -1;
+
+		// ring buffer, _head is the slot the next value goes to
+		std::vector<float> _values;
+		int32_t _head = 0;
+		int32_t _count = 0;
+	};
+
+	// Debug panel built from noMoPi widgets, attach it with UI::setOverlay to see what the screens cost per frame
+	class PerformanceOverlay
+	{
+	public:
+		PerformanceOverlay();
+
+		static std::shared_ptr<PerformanceOverlay> create() { return std::make_shared<PerformanceOverlay>(); }
+
+		// Fractions of the gui size, the panel sits in the top right corner
+		PerformanceOverlay* setSize(float width, float height);
+		PerformanceOverlay* setHistoryLength(int32_t frameCount);
+		const std::shared_ptr<VBox>& getRoot() const { return _root; }
+
+		void resize(int32_t guiWidth, int32_t guiHeight);
+		void update(UI& ui, float deltaTime);
+	private:
+		enum class Metric : uint8_t
+		{
+			LayoutTime,
+			TickTime,
+			WidgetsLaidOut,
+			WidgetsSkipped,
+			TextMeasurements,
+			MeasureCacheHitRate,
+			Allocations,
+			EngineWidgets,
+			Count
+		};
+
+		struct Row
+		{
+			std::shared_ptr<Label> label;
+			std::shared_ptr<Sparkline> sparkline;
+		};
+
+		void _setValue(Metric metric, float value);
+
+		std::shared_ptr<VBox> _root;
+		Row _rows[static_cast<size_t>(Metric::Count)];
+		float _width = 0.25f;
+		float _height = 0.35f;
+
+		// walking the tree for engine widgets is too slow for every frame
+		float _footprintInterval = 0.5f;
+		float _footprintTimer = 0.f;
+		uint32_t _engineWidgetCount = 0;
 	};
 
+	// Mixin for widgets that receive pointer events, UI::tick hit-tests the layout rects and dispatches to them
 	class Interactive
 	{
 	public:
-		void setGui(Unigine::GuiPtr gui);
-		void resize(int32_t width, int32_t height);
-		void attach(const std::shared_ptr<WidgetBase>& widget);
+		virtual ~Interactive();
+
+		Unigine::Event<const Unigine::WidgetPtr&>& getEventEnter() { return _eventEnter; }
+		Unigine::Event<const Unigine::WidgetPtr&>& getEventLeave() { return _eventLeave; }
+		Unigine::Event<const Unigine::WidgetPtr&, int>& getEventClicked() { return _eventClicked; }
 
-		Unigine::Event<const Unigine::WidgetPtr&>& getEventEnter() { return _interactiveLayer->getEventEnter(); }
-		Unigine::Event<const Unigine::WidgetPtr&>& getEventLeave() { return _interactiveLayer->getEventLeave(); }
-		Unigine::Event<const Unigine::WidgetPtr&, int>& getEventClicked() { return _interactiveLayer->getEventClicked(); }
+		// Handlers stay connected for the widget's lifetime
+		template<typename Handler>
+		void onEnter(Handler handler) { _eventEnter.connect(*_addConnection(), [handler](const Unigine::WidgetPtr&) { handler(); }); }
+		template<typename Handler>
+		void onLeave(Handler handler) { _eventLeave.connect(*_addConnection(), [handler](const Unigine::WidgetPtr&) { handler(); }); }
+		template<typename Handler>
+		void onClicked(Handler handler) { _eventClicked.connect(*_addConnection(), [handler](const Unigine::WidgetPtr&, int mouse) { handler(mouse); }); }
+		void disconnectAll();
 	protected:
-		Interactive();
-		
-		Unigine::WidgetButtonPtr _interactiveLayer;
+		Interactive() = default;
+	private:
+		friend class UI;
+
+		Unigine::EventConnection* _addConnection();
+
+		std::vector<Unigine::EventConnection*> _connections;
+
+		Unigine::EventInvoker<const Unigine::WidgetPtr&> _eventEnter;
+		Unigine::EventInvoker<const Unigine::WidgetPtr&> _eventLeave;
+		Unigine::EventInvoker<const Unigine::WidgetPtr&, int> _eventClicked;
+	};
+
+	// Read-only view of a whole file, it stays mapped while the object lives
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile() { close(); }
+
+		bool open(const char* path);
+		void close();
+		const uint8_t* getData() const { return _data; }
+		size_t getSize() const { return _size; }
+	private:
+		const uint8_t* _data = nullptr;
+		size_t _size = 0;
+		void* _mapping = nullptr;
+	};
+
+
+	// Widget trees described in XML files from the layouts folder, see layouts/demo.xml
+	class UIDescription
+	{
+	public:
+		enum class NodeType : uint8_t
+		{
+			HBox,
+			VBox,
+			ScrollBox,
+			Label,
+			EditLine,
+			CheckBox
+		};
+
+		// Attributes a node sets, widgets keep their defaults for the rest
+		enum Field : uint32_t
+		{
+			FieldPadding = 1 << 0,
+			FieldPaddingEqual = 1 << 1,
+			FieldSpacing = 1 << 2,
+			FieldBackground = 1 << 3,
+			FieldBackgroundColor = 1 << 4,
+			FieldBackgroundTexture = 1 << 5,
+			FieldBackgroundFiltering = 1 << 6,
+			FieldNineSlice = 1 << 7,
+			FieldItemCount = 1 << 8,
+			FieldText = 1 << 9,
+			FieldFont = 1 << 10,
+			FieldFontSize = 1 << 11,
+			FieldFontWrap = 1 << 12,
+			FieldFontMaxHSpacing = 1 << 13,
+			FieldFontMaxVSpacing = 1 << 14,
+			FieldFontHSpacing = 1 << 15,
+			FieldFontVSpacing = 1 << 16,
+			FieldAlign = 1 << 17,
+			FieldChecked = 1 << 18
+		};
+
+		// One element with its attributes parsed, strings point into the source and are only valid while it loads
+		struct Node
+		{
+			NodeType type = NodeType::VBox;
+			uint32_t fields = 0;
+			ScaleSettings scaleSettings;
+			const char* id = nullptr;
+
+			// containers, padding is top, bottom, left, right and the nine-slice borders left, right, top, bottom
+			Unigine::Math::vec4 padding;
+			bool isPaddingEqual = false;
+			float spacing = 0.f;
+			bool ignorePadding = false;
+			bool hasBackground = false;
+			Unigine::Math::ivec4 backgroundColor;
+			ResourceId backgroundTexture = InvalidResource;
+			int32_t backgroundFiltering = 0;
+			Unigine::Math::ivec4 nineSlice;
+			int32_t itemCount = 0;
+
+			// labels and edit lines, a font is either a Settings default font index or a file from the fonts folder
+			const char* text = nullptr;
+			bool isTranslatable = true;
+			int32_t defaultFont = -1;
+			ResourceId font = InvalidResource;
+			float fontSize = 1.f;
+			bool fontWrap = false;
+			float fontMaxHSpacing = 0.f;
+			float fontMaxVSpacing = 0.f;
+			float fontHSpacing = 0.f;
+			float fontVSpacing = 0.f;
+			Align horizontalAlign = Align::Left;
+			Align verticalAlign = Align::Top;
+
+			bool isChecked = false;
+		};
+
+		// file is looked up in the layouts folder, errors are logged and leave the description empty
+		bool load(const char* file);
+		bool parse(const char* source);
+		void clear();
+
+		// Compiled descriptions are a versioned, CRC32 checked blob made offline by noMoPiCompiler
+		static bool compile(const char* sourcePath, const char* outputPath);
+		static bool compile(const Unigine::XmlPtr& xml, const char* source, std::vector<uint8_t>& blob);
+		// file is memory-mapped from the layouts folder
+		bool loadCompiled(const char* file);
+		bool instantiate(const uint8_t* data, size_t size, const char* source = "UI description blob");
+
+		// The description keeps its widgets alive until clear or the next load
+		const std::shared_ptr<WidgetBase>& getRoot() const { return _root; }
+		// Widget with the given id attribute, nullptr when there is none or it has another type
+		template<typename Type = WidgetBase>
+		std::shared_ptr<Type> find(const char* id) const
+		{
+			auto it = _ids.find(id);
+			return it != _ids.end() ? std::dynamic_pointer_cast<Type>(it->data) : nullptr;
+		}
+
+		static bool isContainer(NodeType type) { return type == NodeType::HBox || type == NodeType::VBox || type == NodeType::ScrollBox; }
+		static bool parseNode(const Unigine::XmlPtr& xml, Node& node, const char* source);
+		// The widget of a node with every field applied, without children
+		static std::shared_ptr<WidgetBase> createWidget(const Node& node);
+	private:
+		static constexpr uint32_t _compiledMagic = 0x55504d4e; // "NMPU"
+		static constexpr uint32_t _compiledVersion = 1;
+		static constexpr uint32_t _noString = 0xffffffff;
+
+		// followed by the node table, the resource table and the string table
+		struct CompiledHeader
+		{
+			uint32_t magic = _compiledMagic;
+			uint32_t version = _compiledVersion;
+			// of everything after the header
+			uint32_t checksum = 0;
+			uint32_t nodeCount = 0;
+			uint32_t resourceCount = 0;
+			uint32_t stringsSize = 0;
+		};
+
+		// Strings are string table offsets and resources resource table indices, parents come before their children
+		struct CompiledNode
+		{
+			uint8_t type = 0;
+			uint8_t scaleType = 0;
+			uint8_t horizontalAlign = 0;
+			uint8_t verticalAlign = 0;
+			uint32_t fields = 0;
+			int32_t parent = -1;
+			uint32_t id = _noString;
+			uint32_t text = _noString;
+			int32_t backgroundTexture = -1;
+			int32_t font = -1;
+			int32_t defaultFont = -1;
+			int32_t backgroundFiltering = 0;
+			int32_t itemCount = 0;
+			float scaleFactor = 1.f;
+			float spacing = 0.f;
+			float fontSize = 1.f;
+			float fontMaxHSpacing = 0.f;
+			float fontMaxVSpacing = 0.f;
+			float fontHSpacing = 0.f;
+			float fontVSpacing = 0.f;
+			float padding[4] = {};
+			int32_t backgroundColor[4] = {};
+			int32_t nineSlice[4] = {};
+			uint8_t isPaddingEqual = 0;
+			uint8_t ignorePadding = 0;
+			uint8_t hasBackground = 0;
+			uint8_t isTranslatable = 1;
+			uint8_t fontWrap = 0;
+			uint8_t isChecked = 0;
+			uint8_t reserved[2] = {};
+		};
+		static_assert(sizeof(CompiledNode) == 124, "nodes are written as they are in memory, without padding");
+
+		bool _build(const Unigine::XmlPtr& xml, const char* source);
+		// Adds the widget of a node to the parent or makes it the root, id has to stay valid until clear
+		WidgetBase* _addWidget(const Node& node, const char* id, WidgetBase* parent, const char* source);
+
+		std::shared_ptr<WidgetBase> _root;
+		// views into _strings for compiled descriptions and into _parsedIds for parsed ones
+		std::vector<char> _strings;
+		std::deque<Unigine::String> _parsedIds;
+		Unigine::HashMap<std::string_view, std::shared_ptr<WidgetBase>> _ids;
 	};
 }
\ No newline at end of file